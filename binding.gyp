@@ -14,6 +14,7 @@
         'src/QtGui/qmouseevent.cc',
         'src/QtGui/qkeyevent.cc',
         'src/QtGui/qpixmap.cc',
+        'src/QtGui/qpixmapcache.cc',
         'src/QtGui/qpainter.cc',
         'src/QtGui/qcolor.cc',
         'src/QtGui/qbrush.cc',
@@ -25,8 +26,29 @@
         'src/QtGui/qsound.cc',
         'src/QtGui/qscrollarea.cc',
         'src/QtGui/qscrollbar.cc',
+        'src/QtGui/qpicture.cc',
+        'src/QtGui/qimagereader.cc',
+        'src/QtGui/qmovie.cc',
+        'src/QtGui/qgraphicsitem.cc',
+        'src/QtGui/qgraphicsscene.cc',
+        'src/QtGui/qgraphicsview.cc',
 
-        'src/QtTest/qtesteventlist.cc'
+        'src/QtTest/qtesteventlist.cc',
+
+        'src/Extras/pngencoder.cc',
+        'src/Extras/imagestreamwriter.cc',
+        'src/Extras/rawimage.cc',
+        'src/Extras/pixelops.cc',
+        'src/Extras/resampler.cc',
+        'src/Extras/imagepyramid.cc',
+        'src/Extras/pngsave.cc',
+        'src/Extras/imagebuffer.cc',
+        'src/Extras/sharedimage.cc',
+        'src/Extras/imageloader.cc',
+        'src/Extras/inputlog.cc',
+        'src/Extras/itemanimator.cc',
+        'src/Extras/spatialindex.cc',
+        'src/Extras/framecapture.cc'
       ],
       'conditions': [
         ['OS=="mac"', {
@@ -40,18 +62,19 @@
             # TODO: fix node-gyp behavior that requires ../
             '../deps/qt-4.8.0/darwin/x64/lib/QtCore.framework/QtCore', 
             '../deps/qt-4.8.0/darwin/x64/lib/QtGui.framework/QtGui', 
-            '../deps/qt-4.8.0/darwin/x64/lib/QtTest.framework/QtTest'
+            '../deps/qt-4.8.0/darwin/x64/lib/QtTest.framework/QtTest',
+            '-lz'
           ],
         }],
         ['OS=="linux"', {
           'cflags': [
-            '<!@(pkg-config --cflags QtCore QtGui QtTest)'
+            '<!@(pkg-config --cflags QtCore QtGui QtTest zlib)'
           ],
           'ldflags': [
-            '<!@(pkg-config --libs-only-L --libs-only-other QtCore QtGui QtTest)'
+            '<!@(pkg-config --libs-only-L --libs-only-other QtCore QtGui QtTest zlib)'
           ],
           'libraries': [
-            '<!@(pkg-config --libs-only-l QtCore QtGui QtTest)'
+            '<!@(pkg-config --libs-only-l QtCore QtGui QtTest zlib)'
           ]
         }],
         ['OS=="win"', {
@@ -60,6 +83,8 @@
               'deps/qt-4.8.0/win32/ia32/include/QtCore',
               'deps/qt-4.8.0/win32/ia32/include/QtGui',
               'deps/qt-4.8.0/win32/ia32/include/QtTest',
+              # zlib symbols are exported by node itself
+              '<(node_root_dir)/deps/zlib'
           ],
           'libraries': [
               # TODO: fix node-gyp behavior that requires ../
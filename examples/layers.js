@@ -0,0 +1,71 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var qt = require('..');
+
+var app = new qt.QApplication();
+var window = new qt.QWidget;
+window.resize(400, 300);
+
+// Expensive, mostly static background: painted once, then blitted from cache
+window.setLayer('grid', 0, 0, 400, 300, 1, function(pixmap) {
+  console.log('painting grid layer');
+  var p = new qt.QPainter();
+  p.begin(pixmap);
+  p.fillRect(0, 0, 400, 300, qt.GlobalColor.white);
+  for (var x = 0; x < 400; x += 10)
+    p.fillRect(x, 0, 1, 300, qt.GlobalColor.lightGray);
+  for (var y = 0; y < 300; y += 10)
+    p.fillRect(0, y, 400, 1, qt.GlobalColor.lightGray);
+  p.end();
+});
+
+// Counter layer: only repainted when its version is bumped
+var count = 0;
+window.setLayer('counter', 10, 10, 100, 30, count, function(pixmap) {
+  console.log('painting counter layer');
+  var p = new qt.QPainter();
+  p.begin(pixmap);
+  p.drawText(5, 20, 'clicks: ' + count);
+  p.end();
+});
+
+window.mousePressEvent(function() {
+  count++;
+  window.setLayerVersion('counter', count);
+});
+
+window.show();
+
+// Prevent objects from being GC'd
+global.window = window;
+
+setInterval(function() {
+  app.processEvents();
+}, 0);
@@ -40,10 +40,27 @@ try {
 var qt = require(__dirname + '/../build/Release/qt.node');
 process.chdir(oldDir);
 
+//
+// enumeration()
+// Enum tables are built and frozen the first time they are read, so that
+// require('node-qt') doesn't pay for tables a script never touches
+//
+function enumeration(name, build) {
+  Object.defineProperty(qt, name, {
+    configurable: true,
+    enumerable: true,
+    get: function() {
+      var table = Object.freeze(build());
+      Object.defineProperty(qt, name, { value: table, enumerable: true });
+      return table;
+    }
+  });
+}
+
 //
 // Qt::MouseButton
 //
-qt.MouseButton = {
+enumeration('MouseButton', function() { return {
   NoButton         : 0x00000000,
   LeftButton       : 0x00000001,
   RightButton      : 0x00000002,
@@ -52,13 +69,72 @@ qt.MouseButton = {
   XButton1         : 0x00000008,
   XButton2         : 0x00000010,
   MouseButtonMask  : 0x000000ff  
-}
-Object.freeze(qt.MouseButton);
+};
+});
+
+//
+// QEvent::Type, for QWidget.on()/off()
+//
+enumeration('EventType', function() { return {
+  None : 0,
+  MouseButtonPress : 2,
+  MouseButtonRelease : 3,
+  MouseButtonDblClick : 4,
+  MouseMove : 5,
+  KeyPress : 6,
+  KeyRelease : 7,
+  FocusIn : 8,
+  FocusOut : 9,
+  Enter : 10,
+  Leave : 11,
+  Paint : 12,
+  Move : 13,
+  Resize : 14,
+  Show : 17,
+  Hide : 18,
+  Close : 19,
+  WindowActivate : 24,
+  WindowDeactivate : 25,
+  Wheel : 31,
+  ContextMenu : 82,
+  TabletMove : 87,
+  TabletPress : 92,
+  TabletRelease : 93,
+  HoverEnter : 127,
+  HoverLeave : 128,
+  HoverMove : 129,
+  TouchBegin : 194,
+  TouchUpdate : 195,
+  TouchEnd : 196
+};
+});
+
+//
+// Layout of the records passed to QWidget.inputEvents() callbacks. Fields
+// per event family:
+//   Wheel       Value: delta, Value2: orientation, Value3: buttons
+//   MouseMove   Value: buttons
+//   Tablet*     Value: pressure, Value2/3: x/y tilt, Id: unique id
+//   Touch*      one record per point. Value: pressure, Value2: point state,
+//               Id: point id
+//
+enumeration('InputRecord', function() { return {
+  Stride : 8,
+  Type : 0,
+  X : 1,
+  Y : 2,
+  Value : 3,
+  Value2 : 4,
+  Value3 : 5,
+  Id : 6,
+  Modifiers : 7
+};
+});
 
 //
 // Qt::GlobalColor
 //
-qt.GlobalColor = {
+enumeration('GlobalColor', function() { return {
   white : 3,
   black : 2,
   red : 7,
@@ -79,13 +155,102 @@ qt.GlobalColor = {
   transparent : 19,
   color0 : 0,
   color1 : 1
-}
-Object.freeze(qt.GlobalColor);
+};
+});
+
+//
+// QImage::Format
+//
+enumeration('ImageFormat', function() { return {
+  Format_Invalid : 0,
+  Format_Mono : 1,
+  Format_MonoLSB : 2,
+  Format_Indexed8 : 3,
+  Format_RGB32 : 4,
+  Format_ARGB32 : 5,
+  Format_ARGB32_Premultiplied : 6,
+  Format_RGB16 : 7,
+  Format_ARGB8565_Premultiplied : 8,
+  Format_RGB666 : 9,
+  Format_ARGB6666_Premultiplied : 10,
+  Format_RGB555 : 11,
+  Format_ARGB8555_Premultiplied : 12,
+  Format_RGB888 : 13,
+  Format_RGB444 : 14,
+  Format_ARGB4444_Premultiplied : 15
+};
+});
+
+//
+// Filters for QImage.scaled()/scaledAsync()
+//
+enumeration('ResampleFilter', function() { return {
+  Box : 0,
+  Bilinear : 1,
+  Lanczos : 2
+};
+});
+
+enumeration('CacheMode', function() { return {
+  NoCache : 0,
+  ItemCoordinateCache : 1,
+  DeviceCoordinateCache : 2
+};
+});
+
+enumeration('EasingCurve', function() { return {
+  Linear : 0,
+  InQuad : 1,
+  OutQuad : 2,
+  InOutQuad : 3,
+  OutInQuad : 4,
+  InCubic : 5,
+  OutCubic : 6,
+  InOutCubic : 7,
+  OutInCubic : 8,
+  InQuart : 9,
+  OutQuart : 10,
+  InOutQuart : 11,
+  OutInQuart : 12,
+  InQuint : 13,
+  OutQuint : 14,
+  InOutQuint : 15,
+  OutInQuint : 16,
+  InSine : 17,
+  OutSine : 18,
+  InOutSine : 19,
+  OutInSine : 20,
+  InExpo : 21,
+  OutExpo : 22,
+  InOutExpo : 23,
+  OutInExpo : 24,
+  InCirc : 25,
+  OutCirc : 26,
+  InOutCirc : 27,
+  OutInCirc : 28,
+  InElastic : 29,
+  OutElastic : 30,
+  InOutElastic : 31,
+  OutInElastic : 32,
+  InBack : 33,
+  OutBack : 34,
+  InOutBack : 35,
+  OutInBack : 36,
+  InBounce : 37,
+  OutBounce : 38,
+  InOutBounce : 39,
+  OutInBounce : 40,
+  InCurve : 41,
+  OutCurve : 42,
+  SineCurve : 43,
+  CosineCurve : 44
+};
+});
 
 //
 // Qt::Key
 //
-qt.Key = {
+enumeration('Key', function() { return {
   Key_Escape : 0x01000000,                // misc keys
   Key_Tab : 0x01000001,
   Key_Backtab : 0x01000002,
@@ -503,6 +668,6 @@ qt.Key = {
   Key_CameraFocus : 0x01100021,
   Key_unknown : 0x01ffffff
 };
-Object.freeze(qt.Key);
+});
 
 module.exports = qt;
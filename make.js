@@ -17,7 +17,9 @@ target.test = function() {
   
   cd('test');
   rm('-f', 'img-test/*');
-  ls('q*.js').forEach(function(f) {
+  ls('*.js').forEach(function(f) {
+    if (f === 'test.js')
+      return; // helpers
     echo('Running test file '+f);
     exec('node '+f);
   });
@@ -32,3 +34,13 @@ target.ref = function() {
   rm('-f', 'img-ref/*');
   mv('img-test/*', 'img-ref');
 }
+
+target.bench = function() {
+  cd(root);
+
+  echo('_________________________________________________________________');
+  echo('Node-Qt startup time');
+  echo();
+
+  exec('node tools/startup.js');
+}
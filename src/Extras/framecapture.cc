@@ -0,0 +1,351 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <node.h>
+#include <node_buffer.h>
+#include <QTimerEvent>
+#include "../qt_v8.h"
+#include "framecapture.h"
+
+using namespace v8;
+
+Persistent<Function> FrameCapture::constructor;
+
+FrameCapture::FrameCapture(QWidgetImpl* widget, int count)
+    : widget_(widget), count_(count), started_(false), withDamage_(false),
+      serial_(0), dropped_(0) {
+}
+
+FrameCapture::~FrameCapture() {
+  stop();
+  NanDispose(widgetHandle_);
+
+  for (int i = 0; i < ring_.size(); ++i)
+    NanDispose(ring_[i].buffer);
+}
+
+void FrameCapture::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("FrameCapture"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("start"),
+      FunctionTemplate::New(Start)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("stop"),
+      FunctionTemplate::New(Stop)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("release"),
+      FunctionTemplate::New(Release)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("frameCount"),
+      FunctionTemplate::New(FrameCount)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("dropped"),
+      FunctionTemplate::New(Dropped)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("FrameCapture"), tpl->GetFunction());
+}
+
+// Supported implementations:
+//   FrameCapture ( QWidget widget )
+//   FrameCapture ( QWidget widget, Number slots )
+// slots defaults to 3: one being encoded, one queued, one being filled
+NAN_METHOD(FrameCapture::New) {
+  NanScope();
+
+  if (!args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QWidget")
+    return NanThrowTypeError("FrameCapture::FrameCapture: bad arguments");
+
+  int count = 3;
+  if (args.Length() > 1) {
+    count = args[1]->Int32Value();
+    if (count < 1 || count > 64)
+      return NanThrowRangeError("FrameCapture::FrameCapture: slots must be "
+                                "between 1 and 64");
+  }
+
+  QWidgetImpl* widget = ObjectWrap::Unwrap<QWidgetWrap>(
+      args[0]->ToObject())->GetWrapped();
+
+  FrameCapture* w = new FrameCapture(widget, count);
+  NanAssignPersistent(Object, w->widgetHandle_, args[0]->ToObject());
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+// (Re)creates the canvas and the ring for frames of the given size. Frames
+// queued for the old ring are dropped; Buffers already handed to JS stay
+// valid, as node owns their memory
+void FrameCapture::allocate(const QSize& size) {
+  NanScope();
+
+  canvas_ = QImage(size, QImage::Format_ARGB32_Premultiplied);
+  canvas_.fill(0);
+
+  dropped_ += pending_.size();
+  pending_.clear();
+
+  ring_.resize(count_);
+  for (int i = 0; i < ring_.size(); ++i) {
+    Slot& slot = ring_[i];
+    NanDispose(slot.buffer);
+
+    Local<Object> buffer = NanNewBufferHandle(canvas_.byteCount());
+    NanAssignPersistent(Object, slot.buffer, buffer);
+    slot.image = QImage(reinterpret_cast<uchar*>(node::Buffer::Data(buffer)),
+                        size.width(), size.height(), canvas_.bytesPerLine(),
+                        QImage::Format_ARGB32_Premultiplied);
+    slot.image.fill(0);
+    slot.stale = QRegion();
+    slot.busy = false;
+  }
+}
+
+QImage* FrameCapture::beginFrame(const QSize& size) {
+  Ref();
+
+  if (canvas_.size() != size)
+    allocate(size);
+
+  return &canvas_;
+}
+
+void FrameCapture::endFrame(const QRegion& damage) {
+  if (started_)
+    queueFrame(damage);
+
+  Unref();
+}
+
+void FrameCapture::queueFrame(const QRegion& damage) {
+  QRegion changed = damage & canvas_.rect();
+
+  for (int i = 0; i < ring_.size(); ++i)
+    ring_[i].stale += changed;
+
+  int next = -1;
+  for (int i = 0; i < ring_.size() && next < 0; ++i)
+    if (!ring_[i].busy)
+      next = i;
+
+  if (next < 0) {
+    ++dropped_;
+    return;
+  }
+
+  // Only what changed since this slot's last frame is copied
+  Slot& slot = ring_[next];
+  QVector<QRect> rects = slot.stale.rects();
+  for (int i = 0; i < rects.size(); ++i) {
+    const QRect& r = rects[i];
+    int bytes = r.width() * 4;
+    for (int y = r.top(); y <= r.bottom(); ++y) {
+      memcpy(slot.image.scanLine(y) + r.left() * 4,
+             canvas_.constScanLine(y) + r.left() * 4, bytes);
+    }
+  }
+  slot.stale = QRegion();
+  slot.busy = true;
+
+  Frame frame;
+  frame.slot = next;
+  frame.serial = serial_++;
+  frame.time = clock_.nsecsElapsed() / 1e6;
+  frame.damage = changed;
+  pending_.append(frame);
+
+  // Delivered once the paint is over, so JS never runs inside it
+  if (!timer_.isActive())
+    timer_.start(0, this);
+}
+
+void FrameCapture::detach() {
+  // Called from the widget's destructor; don't touch it
+  widget_ = NULL;
+  stop();
+}
+
+void FrameCapture::stop() {
+  if (!started_)
+    return;
+
+  if (widget_)
+    widget_->setCapture(NULL);
+
+  started_ = false;
+  timer_.stop();
+  unqueue(pending_, 0);
+  pending_.clear();
+  NanDispose(callback_);
+  Unref();
+}
+
+// Frees the slots of frames that JS never saw, and so can't release()
+void FrameCapture::unqueue(const QList<Frame>& frames, int from) {
+  for (int i = from; i < frames.size(); ++i)
+    ring_[frames[i].slot].busy = false;
+}
+
+void FrameCapture::timerEvent(QTimerEvent* e) {
+  if (e->timerId() != timer_.timerId()) {
+    QObject::timerEvent(e);
+    return;
+  }
+
+  timer_.stop();
+  deliver();
+}
+
+// Calls back with { slot, buffer, width, height, stride, serial, time }
+// and, if requested, damage: [[x, y, w, h], ...]
+void FrameCapture::deliver() {
+  // The callback may stop the capture or trigger paints
+  QList<Frame> frames = pending_;
+  pending_.clear();
+
+  int i = 0;
+  for (; i < frames.size() && started_; ++i) {
+    NanScope();
+
+    const Frame& f = frames[i];
+    const Slot& slot = ring_[f.slot];
+
+    Local<Object> frame = Object::New();
+    frame->Set(String::NewSymbol("slot"), Integer::New(f.slot));
+    frame->Set(String::NewSymbol("buffer"), NanPersistentToLocal(slot.buffer));
+    frame->Set(String::NewSymbol("width"), Integer::New(slot.image.width()));
+    frame->Set(String::NewSymbol("height"), Integer::New(slot.image.height()));
+    frame->Set(String::NewSymbol("stride"),
+               Integer::New(slot.image.bytesPerLine()));
+    frame->Set(String::NewSymbol("serial"), Integer::NewFromUnsigned(f.serial));
+    frame->Set(String::NewSymbol("time"), Number::New(f.time));
+
+    if (withDamage_) {
+      QVector<QRect> rects = f.damage.rects();
+      Local<Array> damage = Array::New(rects.size());
+      for (int j = 0; j < rects.size(); ++j) {
+        Local<Array> r = Array::New(4);
+        r->Set(0, Integer::New(rects[j].x()));
+        r->Set(1, Integer::New(rects[j].y()));
+        r->Set(2, Integer::New(rects[j].width()));
+        r->Set(3, Integer::New(rects[j].height()));
+        damage->Set(j, r);
+      }
+      frame->Set(String::NewSymbol("damage"), damage);
+    }
+
+    const unsigned argc = 1;
+    Handle<Value> argv[argc] = {
+      frame
+    };
+
+    NanPersistentToLocal(callback_)->Call(Context::GetCurrent()->Global(),
+                                          argc, argv);
+  }
+
+  unqueue(frames, i);
+}
+
+// Supported versions:
+//   start(Function callback)
+//   start(Function callback, Boolean damage)
+// callback(frame) runs after each paint of the widget. frame.slot must be
+// release()d once frame.buffer has been consumed
+NAN_METHOD(FrameCapture::Start) {
+  NanScope();
+
+  FrameCapture* w = ObjectWrap::Unwrap<FrameCapture>(args.This());
+
+  if (!args[0]->IsFunction())
+    return NanThrowTypeError("FrameCapture::start: bad arguments");
+
+  if (!w->widget_)
+    return NanThrowError("FrameCapture::start: widget was destroyed");
+
+  if (w->started_)
+    return NanThrowError("FrameCapture::start: already started");
+
+  if (w->widget_->capture())
+    return NanThrowError("FrameCapture::start: widget is already captured");
+
+  NanAssignPersistent(Function, w->callback_, Local<Function>::Cast(args[0]));
+  w->withDamage_ = args[1]->BooleanValue();
+  w->started_ = true;
+  w->clock_.start();
+
+  // Stays alive while capturing, even if scripts drop their handle
+  w->Ref();
+
+  w->widget_->setCapture(w);
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(FrameCapture::Stop) {
+  NanScope();
+
+  FrameCapture* w = ObjectWrap::Unwrap<FrameCapture>(args.This());
+  w->stop();
+
+  NanReturnUndefined();
+}
+
+// Hands the slot back for reuse. Its Buffer must not be read afterwards
+NAN_METHOD(FrameCapture::Release) {
+  NanScope();
+
+  FrameCapture* w = ObjectWrap::Unwrap<FrameCapture>(args.This());
+
+  int slot = args[0]->Int32Value();
+  if (!args[0]->IsNumber() || slot < 0 || slot >= w->ring_.size())
+    return NanThrowRangeError("FrameCapture::release: no such slot");
+
+  w->ring_[slot].busy = false;
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(FrameCapture::FrameCount) {
+  NanScope();
+
+  FrameCapture* w = ObjectWrap::Unwrap<FrameCapture>(args.This());
+
+  NanReturnValue(Integer::NewFromUnsigned(w->serial_));
+}
+
+// Frames skipped because every slot was still held by JS
+NAN_METHOD(FrameCapture::Dropped) {
+  NanScope();
+
+  FrameCapture* w = ObjectWrap::Unwrap<FrameCapture>(args.This());
+
+  NanReturnValue(Integer::NewFromUnsigned(w->dropped_));
+}
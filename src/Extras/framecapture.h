@@ -0,0 +1,120 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <node.h>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QRegion>
+#include <QVector>
+#include <nan.h>
+#include "../QtGui/qwidget.h"
+
+//
+// FrameCapture
+// Hands every frame a widget paints to JS, for screen recording. Frames
+// are kept in a ring of preallocated Buffers. Each Buffer is the memory of
+// a 32-bit premultiplied ARGB image, so consumers read pixels in place.
+// A slot is reused only after JS release()s it; when every slot is busy
+// the frame is dropped rather than stalling paints. Slots are brought up
+// to date by copying only the pixels damaged since they last held a
+// frame. Not a Qt class
+//
+class FrameCapture : public QObject, public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+
+  // Called by QWidgetImpl around a captured paint. The capture stays
+  // referenced in between, even if the paint callback stop()s it
+  QImage* beginFrame(const QSize& size);
+  void endFrame(const QRegion& damage);
+  // The widget is being destroyed
+  void detach();
+
+ protected:
+  void timerEvent(QTimerEvent* e);
+
+ private:
+  FrameCapture(QWidgetImpl* widget, int count);
+  ~FrameCapture();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(Start);
+  static NAN_METHOD(Stop);
+  static NAN_METHOD(Release);
+  static NAN_METHOD(FrameCount);
+  static NAN_METHOD(Dropped);
+
+  void allocate(const QSize& size);
+  void queueFrame(const QRegion& damage);
+  void stop();
+  void deliver();
+
+  struct Slot {
+    v8::Persistent<v8::Object> buffer;
+    QImage image;       // over the Buffer's memory
+    QRegion stale;      // damaged since the slot last held a frame
+    bool busy;          // handed to JS and not yet released
+  };
+
+  struct Frame {
+    int slot;
+    quint32 serial;
+    double time;
+    QRegion damage;
+  };
+
+  void unqueue(const QList<Frame>& frames, int from);
+
+  QPointer<QWidgetImpl> widget_;
+  v8::Persistent<v8::Object> widgetHandle_;
+  int count_;
+  QVector<Slot> ring_;
+  QImage canvas_;
+
+  bool started_;
+  bool withDamage_;
+  v8::Persistent<v8::Function> callback_;
+  QList<Frame> pending_;
+  QBasicTimer timer_;
+
+  QElapsedTimer clock_;
+  quint32 serial_;
+  quint32 dropped_;
+};
+
+#endif
@@ -0,0 +1,118 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <QBuffer>
+#include <QImageWriter>
+#include "../qt_v8.h"
+#include "imagebuffer.h"
+
+using namespace v8;
+
+namespace {
+
+void freeByteArray(char* data, void* hint) {
+  delete static_cast<QByteArray*>(hint);
+}
+
+//
+// EncodeWorker
+// The image is an implicitly shared copy taken on the main thread
+//
+class EncodeWorker : public NanAsyncWorker {
+ public:
+  EncodeWorker(NanCallback* callback, const QImage& image,
+               const QByteArray& format, int quality)
+      : NanAsyncWorker(callback), image_(image), format_(format),
+        quality_(quality), data_(NULL) {}
+
+  ~EncodeWorker() {
+    // Only still set if the callback never took it
+    delete data_;
+  }
+
+  void Execute() {
+    data_ = ImageBuffer::encode(image_, format_, quality_, &error_);
+  }
+
+  void HandleOKCallback() {
+    NanScope();
+
+    Local<Value> argv[2];
+    if (data_) {
+      argv[0] = Local<Value>::New(Null());
+      argv[1] = ImageBuffer::toBuffer(data_);
+      data_ = NULL;
+    } else {
+      argv[0] = Exception::Error(qt_v8::FromQString(error_));
+      argv[1] = Local<Value>::New(Null());
+    }
+    callback->Run(2, argv);
+  }
+
+ private:
+  QImage image_;
+  QByteArray format_;
+  int quality_;
+  QByteArray* data_;
+  QString error_;
+};
+
+}
+
+QByteArray* ImageBuffer::encode(const QImage& image, const QByteArray& format,
+                                int quality, QString* error) {
+  if (image.isNull()) {
+    *error = "image is null";
+    return NULL;
+  }
+
+  QByteArray* data = new QByteArray;
+  QBuffer buffer(data);
+  buffer.open(QIODevice::WriteOnly);
+
+  QImageWriter writer(&buffer, format);
+  writer.setQuality(quality);
+  if (!writer.write(image)) {
+    *error = writer.errorString();
+    delete data;
+    return NULL;
+  }
+
+  return data;
+}
+
+Local<Object> ImageBuffer::toBuffer(QByteArray* data) {
+  return NanNewBufferHandle(data->data(), data->size(), freeByteArray, data);
+}
+
+void ImageBuffer::encodeAsync(const QImage& image, const QByteArray& format,
+                              int quality, Local<Function> callback) {
+  NanAsyncQueueWorker(new EncodeWorker(new NanCallback(callback), image,
+                                       format, quality));
+}
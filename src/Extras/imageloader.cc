@@ -0,0 +1,237 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <node_buffer.h>
+#include <QBuffer>
+#include <QImageReader>
+#include "../qt_v8.h"
+#include "../QtGui/qimage.h"
+#include "imageloader.h"
+
+using namespace v8;
+
+Persistent<Function> ImageLoader::constructor;
+
+ImageLoader::ImageLoader(int partialStep)
+    : partialStep_(partialStep), nextPartial_(partialStep), ended_(false) {
+}
+
+ImageLoader::~ImageLoader() {
+  NanDispose(headerCallback_);
+  NanDispose(partialCallback_);
+}
+
+void ImageLoader::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("ImageLoader"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("write"),
+      FunctionTemplate::New(Write)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("end"),
+      FunctionTemplate::New(End)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("bytesReceived"),
+      FunctionTemplate::New(BytesReceived)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("headerEvent"),
+      FunctionTemplate::New(HeaderEvent)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("partialEvent"),
+      FunctionTemplate::New(PartialEvent)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("ImageLoader"), tpl->GetFunction());
+}
+
+// Supported implementations:
+//   ImageLoader ( )
+//   ImageLoader ( { partialStep: bytes } )
+// partialStep (default 64KB) is the minimum growth between partial decodes
+NAN_METHOD(ImageLoader::New) {
+  NanScope();
+
+  int partialStep = 64 * 1024;
+  if (args[0]->IsObject()) {
+    Local<Value> value =
+        args[0]->ToObject()->Get(String::NewSymbol("partialStep"));
+    if (value->IsNumber())
+      partialStep = qMax(1, (int)value->IntegerValue());
+  }
+
+  ImageLoader* w = new ImageLoader(partialStep);
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+// Calls the header callback once the format and size can be read
+void ImageLoader::probeHeader() {
+  QBuffer buffer(&data_);
+  buffer.open(QIODevice::ReadOnly);
+  QImageReader reader(&buffer);
+
+  QSize size = reader.size();
+  if (!size.isValid())
+    return;
+
+  size_ = size;
+  format_ = reader.format();
+
+  if (headerCallback_.IsEmpty())
+    return;
+
+  const unsigned argc = 3;
+  Handle<Value> argv[argc] = {
+    Integer::New(size_.width()),
+    Integer::New(size_.height()),
+    qt_v8::FromQString(QString::fromLatin1(format_))
+  };
+  NanPersistentToLocal(headerCallback_)->Call(
+      Context::GetCurrent()->Global(), argc, argv);
+}
+
+// Decodes what has arrived so far. Only JPEG is attempted: Qt's handler
+// pads truncated input with an EOI marker and returns the rows it has,
+// whereas the other handlers fail (and log) on short data
+void ImageLoader::decodePartial() {
+  if (format_ != "jpeg" || partialCallback_.IsEmpty())
+    return;
+
+  QBuffer buffer(&data_);
+  buffer.open(QIODevice::ReadOnly);
+  QImageReader reader(&buffer, format_);
+  QImage image = reader.read();
+  if (image.isNull())
+    return;
+
+  const unsigned argc = 1;
+  Handle<Value> argv[argc] = { QImageWrap::NewInstance(image) };
+  NanPersistentToLocal(partialCallback_)->Call(
+      Context::GetCurrent()->Global(), argc, argv);
+}
+
+// Supported versions:
+//   write( Buffer chunk )
+NAN_METHOD(ImageLoader::Write) {
+  NanScope();
+
+  ImageLoader* w = ObjectWrap::Unwrap<ImageLoader>(args.This());
+
+  if (w->ended_)
+    return NanThrowError("ImageLoader::Write: loader has ended");
+  if (!node::Buffer::HasInstance(args[0]))
+    return NanThrowTypeError("ImageLoader::Write: bad argument");
+
+  w->data_.append(node::Buffer::Data(args[0]->ToObject()),
+                  node::Buffer::Length(args[0]->ToObject()));
+
+  if (!w->size_.isValid())
+    w->probeHeader();
+
+  if (w->size_.isValid() && w->data_.size() >= w->nextPartial_) {
+    // Grow the step with the data so re-decoding stays linear overall
+    w->nextPartial_ = w->data_.size() +
+        qMax(w->partialStep_, w->data_.size() / 4);
+    w->decodePartial();
+  }
+
+  NanReturnUndefined();
+}
+
+// Decodes the complete image and releases the compressed data. Throws if
+// it can't be decoded
+NAN_METHOD(ImageLoader::End) {
+  NanScope();
+
+  ImageLoader* w = ObjectWrap::Unwrap<ImageLoader>(args.This());
+
+  if (w->ended_)
+    return NanThrowError("ImageLoader::End: loader has ended");
+  w->ended_ = true;
+
+  QImage image;
+  QString error;
+  {
+    QBuffer buffer(&w->data_);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    image = reader.read();
+    error = reader.errorString();
+  }
+  w->data_ = QByteArray();
+
+  if (image.isNull())
+    return NanThrowError(("ImageLoader::End: " + error).toUtf8().constData());
+
+  NanReturnValue(QImageWrap::NewInstance(image));
+}
+
+NAN_METHOD(ImageLoader::BytesReceived) {
+  NanScope();
+
+  ImageLoader* w = ObjectWrap::Unwrap<ImageLoader>(args.This());
+
+  NanReturnValue(Integer::New(w->data_.size()));
+}
+
+//
+// HeaderEvent()
+// Binds callback(width, height, format), called once the header is in.
+// Anything but a function unbinds
+//
+NAN_METHOD(ImageLoader::HeaderEvent) {
+  NanScope();
+
+  ImageLoader* w = ObjectWrap::Unwrap<ImageLoader>(args.This());
+
+  NanDispose(w->headerCallback_);
+  if (args[0]->IsFunction())
+    NanAssignPersistent(Function, w->headerCallback_,
+                        Local<Function>::Cast(args[0]));
+
+  NanReturnUndefined();
+}
+
+//
+// PartialEvent()
+// Binds callback(image), called with each partial decode. Anything but
+// a function unbinds
+//
+NAN_METHOD(ImageLoader::PartialEvent) {
+  NanScope();
+
+  ImageLoader* w = ObjectWrap::Unwrap<ImageLoader>(args.This());
+
+  NanDispose(w->partialCallback_);
+  if (args[0]->IsFunction())
+    NanAssignPersistent(Function, w->partialCallback_,
+                        Local<Function>::Cast(args[0]));
+
+  NanReturnUndefined();
+}
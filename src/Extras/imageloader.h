@@ -0,0 +1,79 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <node.h>
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+#include <nan.h>
+
+//
+// ImageLoader
+// Decodes an image fed to it in chunks, e.g. from a Node stream. The
+// header callback fires as soon as enough bytes have arrived to know the
+// image size; for formats whose Qt handler decodes truncated data (JPEG)
+// the partial callback gets a preview whose top rows are already real,
+// re-decoded as the data grows geometrically. The compressed bytes are
+// dropped as soon as end() has decoded them. Not a Qt class
+//
+class ImageLoader : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+
+ private:
+  ImageLoader(int partialStep);
+  ~ImageLoader();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(Write);
+  static NAN_METHOD(End);
+  static NAN_METHOD(BytesReceived);
+  static NAN_METHOD(HeaderEvent);
+  static NAN_METHOD(PartialEvent);
+
+  void probeHeader();
+  void decodePartial();
+
+  QByteArray data_;
+  QByteArray format_;
+  QSize size_;
+  int partialStep_;
+  int nextPartial_;
+  bool ended_;
+
+  v8::Persistent<v8::Function> headerCallback_;
+  v8::Persistent<v8::Function> partialCallback_;
+};
+
+#endif
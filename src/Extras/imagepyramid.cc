@@ -0,0 +1,155 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cmath>
+#include "../qt_v8.h"
+#include "../QtGui/qimage.h"
+#include "imagepyramid.h"
+#include "resampler.h"
+
+using namespace v8;
+
+Persistent<Function> ImagePyramid::constructor;
+
+ImagePyramid::ImagePyramid(const QImage& image) {
+  int count = 1;
+  for (int w = image.width(), h = image.height(); w > 1 || h > 1; ++count) {
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+
+  levels_.resize(count);
+  levels_[0] = image;
+}
+
+ImagePyramid::~ImagePyramid() {
+}
+
+void ImagePyramid::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("ImagePyramid"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("levelCount"),
+      FunctionTemplate::New(LevelCount)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("level"),
+      FunctionTemplate::New(Level)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("levelForScale"),
+      FunctionTemplate::New(LevelForScale)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("ImagePyramid"), tpl->GetFunction());
+}
+
+// Supported implementations:
+//   ImagePyramid ( QImage image )
+// The pyramid keeps a (shared) copy of image as it was when constructed
+NAN_METHOD(ImagePyramid::New) {
+  NanScope();
+
+  QString arg0_constructor;
+  if (args[0]->IsObject()) {
+    arg0_constructor =
+        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  }
+
+  if (arg0_constructor != "QImage")
+    return NanThrowTypeError("ImagePyramid: bad arguments");
+
+  QImage* image =
+      ObjectWrap::Unwrap<QImageWrap>(args[0]->ToObject())->GetWrapped();
+  if (image->isNull())
+    return NanThrowTypeError("ImagePyramid: image is null");
+
+  ImagePyramid* w = new ImagePyramid(*image);
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+const QImage& ImagePyramid::level(int n) {
+  n = qBound(0, n, levels_.size() - 1);
+  if (levels_[n].isNull()) {
+    // A box filter at exactly half size is a 2x2 average
+    const QImage& parent = level(n - 1);
+    levels_[n] = Resampler::resample(parent, (parent.width() + 1) / 2,
+                                     (parent.height() + 1) / 2,
+                                     Resampler::Box);
+  }
+  return levels_[n];
+}
+
+const QImage& ImagePyramid::levelForScale(qreal scale) {
+  if (scale <= 0 || scale >= 1)
+    return level(0);
+  return level((int)floor(log(1 / scale) / log(2.0)));
+}
+
+void ImagePyramid::draw(QPainter* painter, qreal x, qreal y) {
+  const QTransform& t = painter->worldTransform();
+  // The larger of the two axis scales, so neither axis is undersampled
+  qreal scale = qMax(sqrt(t.m11() * t.m11() + t.m12() * t.m12()),
+                     sqrt(t.m21() * t.m21() + t.m22() * t.m22()));
+
+  const QImage& source = levels_[0];
+  painter->drawImage(QRectF(x, y, source.width(), source.height()),
+                     levelForScale(scale));
+}
+
+NAN_METHOD(ImagePyramid::LevelCount) {
+  NanScope();
+
+  ImagePyramid* w = ObjectWrap::Unwrap<ImagePyramid>(args.This());
+
+  NanReturnValue(Integer::New(w->levels_.size()));
+}
+
+// Level n (0 is the source), building it and any missing parents first
+NAN_METHOD(ImagePyramid::Level) {
+  NanScope();
+
+  ImagePyramid* w = ObjectWrap::Unwrap<ImagePyramid>(args.This());
+
+  int n = args[0]->IntegerValue();
+  if (n < 0 || n >= w->levels_.size())
+    return NanThrowRangeError("ImagePyramid::Level: no such level");
+
+  NanReturnValue(QImageWrap::NewInstance(w->level(n)));
+}
+
+NAN_METHOD(ImagePyramid::LevelForScale) {
+  NanScope();
+
+  ImagePyramid* w = ObjectWrap::Unwrap<ImagePyramid>(args.This());
+
+  NanReturnValue(QImageWrap::NewInstance(
+      w->levelForScale(args[0]->NumberValue())));
+}
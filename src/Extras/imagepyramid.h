@@ -0,0 +1,73 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <node.h>
+#include <QImage>
+#include <QPainter>
+#include <QVector>
+#include <nan.h>
+
+//
+// ImagePyramid
+// Mipmap chain of successive half-resolution copies of an image, built
+// lazily on first use. QPainter.drawImage() accepts a pyramid and draws
+// the smallest level that still covers the painter's current scale, so
+// zoomed-out frames don't resample the full-resolution source. Not a Qt
+// class
+//
+class ImagePyramid : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+
+  // Level whose resolution is at least scale times the source's
+  const QImage& levelForScale(qreal scale);
+  // Draws the source's full size at (x, y) from the appropriate level
+  void draw(QPainter* painter, qreal x, qreal y);
+
+ private:
+  ImagePyramid(const QImage& image);
+  ~ImagePyramid();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(LevelCount);
+  static NAN_METHOD(Level);
+  static NAN_METHOD(LevelForScale);
+
+  const QImage& level(int n);
+
+  // levels_[0] is the source; others are null until first needed
+  QVector<QImage> levels_;
+};
+
+#endif
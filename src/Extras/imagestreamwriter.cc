@@ -0,0 +1,315 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <node.h>
+#include <QFile>
+#include "../qt_v8.h"
+#include "../QtGui/qimage.h"
+#include "../QtGui/qpixmap.h"
+#include "imagestreamwriter.h"
+
+using namespace v8;
+
+Persistent<Function> ImageStreamWriter::constructor;
+
+ImageStreamWriter::ImageStreamWriter(QIODevice* device, int width, int height,
+                                     Format format, bool alpha,
+                                     int compression)
+    : device_(device), png_(NULL), format_(format), width_(width),
+      height_(height), rows_(0), closed_(false) {
+  if (format_ == Png)
+    png_ = new PngEncoder(device_, width, height, alpha, compression);
+}
+
+ImageStreamWriter::~ImageStreamWriter() {
+  delete png_;
+  delete device_;
+  NanDispose(sink_);
+}
+
+void ImageStreamWriter::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("ImageStreamWriter"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("write"),
+      FunctionTemplate::New(Write)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("rowsWritten"),
+      FunctionTemplate::New(RowsWritten)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("close"),
+      FunctionTemplate::New(Close)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("ImageStreamWriter"), tpl->GetFunction());
+}
+
+// Supported implementations:
+//   ImageStreamWriter ( String filename, int width, int height,
+//                       String format, Object options )
+//   ImageStreamWriter ( int fd, ... )
+//   ImageStreamWriter ( Function sink, ... )
+//
+// format is 'png' (default), 'ppm' (binary RGB) or 'raw' (headerless RGBA
+// rows). options: { alpha: Boolean, compression: 0-9 }, PNG only.
+// A sink function is called with a Buffer of encoded bytes after every
+// write() and close(), e.g. to feed a Node stream.
+NAN_METHOD(ImageStreamWriter::New) {
+  NanScope();
+
+  if (!args[1]->IsNumber() || !args[2]->IsNumber())
+    return NanThrowTypeError("ImageStreamWriter: bad arguments");
+
+  int width = args[1]->IntegerValue();
+  int height = args[2]->IntegerValue();
+  if (width <= 0 || height <= 0)
+    return NanThrowRangeError("ImageStreamWriter: bad image size");
+
+  Format format = Png;
+  if (args[3]->IsString()) {
+    QString name = qt_v8::ToQString(args[3]->ToString()).toLower();
+    if (name == "ppm")
+      format = Ppm;
+    else if (name == "raw")
+      format = Raw;
+    else if (name != "png")
+      return NanThrowTypeError("ImageStreamWriter: unsupported format");
+  }
+
+  bool alpha = true;
+  int compression = 6;
+  if (args[4]->IsObject()) {
+    Local<Object> options = args[4]->ToObject();
+    Local<Value> value = options->Get(String::NewSymbol("alpha"));
+    if (!value->IsUndefined())
+      alpha = value->BooleanValue();
+    value = options->Get(String::NewSymbol("compression"));
+    if (value->IsNumber())
+      compression = value->IntegerValue();
+  }
+
+  QIODevice* device;
+  if (args[0]->IsString()) {
+    device = new QFile(qt_v8::ToQString(args[0]->ToString()));
+    device->open(QIODevice::WriteOnly | QIODevice::Truncate);
+  } else if (args[0]->IsNumber()) {
+    // The descriptor stays owned (and is closed) by the caller
+    QFile* file = new QFile;
+    file->open(args[0]->IntegerValue(), QIODevice::WriteOnly);
+    device = file;
+  } else if (args[0]->IsFunction()) {
+    device = new QBuffer;
+    device->open(QIODevice::WriteOnly);
+  } else {
+    return NanThrowTypeError("ImageStreamWriter: bad target");
+  }
+
+  if (!device->isOpen()) {
+    QString error = "ImageStreamWriter: " + device->errorString();
+    delete device;
+    return NanThrowError(error.toUtf8().constData());
+  }
+
+  ImageStreamWriter* w = new ImageStreamWriter(device, width, height, format,
+                                               alpha, compression);
+  w->Wrap(args.This());
+
+  if (args[0]->IsFunction())
+    NanAssignPersistent(Function, w->sink_, Local<Function>::Cast(args[0]));
+
+  if (!w->begin())
+    return NanThrowError(w->error_.toUtf8().constData());
+  w->flushSink();
+
+  NanReturnValue(args.This());
+}
+
+bool ImageStreamWriter::begin() {
+  if (format_ == Png) {
+    if (!png_->begin()) {
+      error_ = png_->errorString();
+      return false;
+    }
+  } else if (format_ == Ppm) {
+    QByteArray header = "P6\n" + QByteArray::number(width_) + " " +
+                        QByteArray::number(height_) + "\n255\n";
+    if (device_->write(header) != header.size()) {
+      error_ = device_->errorString();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool ImageStreamWriter::writeRows(const QImage& strip) {
+  if (strip.width() != width_) {
+    error_ = "ImageStreamWriter: strip width does not match image width";
+    return false;
+  }
+  if (rows_ + strip.height() > height_) {
+    error_ = "ImageStreamWriter: too many rows";
+    return false;
+  }
+
+  if (format_ == Png) {
+    if (!png_->writeRows(strip)) {
+      error_ = png_->errorString();
+      return false;
+    }
+    rows_ += strip.height();
+    return true;
+  }
+
+  QImage argb = strip.convertToFormat(QImage::Format_ARGB32);
+  int channels = format_ == Ppm ? 3 : 4;
+  QByteArray row(width_ * channels, 0);
+
+  for (int y = 0; y < argb.height(); ++y) {
+    const QRgb* src = (const QRgb*)argb.constScanLine(y);
+    char* dst = row.data();
+
+    for (int x = 0; x < width_; ++x) {
+      *dst++ = qRed(src[x]);
+      *dst++ = qGreen(src[x]);
+      *dst++ = qBlue(src[x]);
+      if (channels == 4)
+        *dst++ = qAlpha(src[x]);
+    }
+
+    if (device_->write(row) != row.size()) {
+      error_ = device_->errorString();
+      return false;
+    }
+    ++rows_;
+  }
+
+  return true;
+}
+
+bool ImageStreamWriter::finish() {
+  if (rows_ != height_) {
+    error_ = "ImageStreamWriter: image is incomplete";
+    return false;
+  }
+
+  if (format_ == Png && !png_->finish()) {
+    error_ = png_->errorString();
+    return false;
+  }
+
+  return true;
+}
+
+// Hands everything encoded so far over to the JS sink, if any
+void ImageStreamWriter::flushSink() {
+  if (sink_.IsEmpty())
+    return;
+
+  QBuffer* buffer = static_cast<QBuffer*>(device_);
+  if (buffer->data().isEmpty())
+    return;
+
+  NanScope();
+
+  const unsigned argc = 1;
+  Handle<Value> argv[argc] = {
+    NanNewBufferHandle((char*)buffer->data().constData(),
+                       buffer->data().size())
+  };
+
+  buffer->buffer().clear();
+  buffer->seek(0);
+
+  NanPersistentToLocal(sink_)->Call(Context::GetCurrent()->Global(),
+                                    argc, argv);
+}
+
+// Supported versions:
+//   write( QImage strip )
+//   write( QPixmap strip )
+NAN_METHOD(ImageStreamWriter::Write) {
+  NanScope();
+
+  ImageStreamWriter* w = ObjectWrap::Unwrap<ImageStreamWriter>(args.This());
+
+  if (w->closed_)
+    return NanThrowError("ImageStreamWriter::Write: writer is closed");
+
+  QString arg0_constructor;
+  if (args[0]->IsObject()) {
+    arg0_constructor =
+        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  }
+
+  QImage strip;
+  if (arg0_constructor == "QImage") {
+    QImageWrap* image_wrap = ObjectWrap::Unwrap<QImageWrap>(
+        args[0]->ToObject());
+    strip = *image_wrap->GetWrapped();
+  } else if (arg0_constructor == "QPixmap") {
+    QPixmapWrap* pixmap_wrap = ObjectWrap::Unwrap<QPixmapWrap>(
+        args[0]->ToObject());
+    strip = pixmap_wrap->GetWrapped()->toImage();
+  } else {
+    return NanThrowTypeError("ImageStreamWriter::Write: bad argument");
+  }
+
+  if (!w->writeRows(strip))
+    return NanThrowError(w->error_.toUtf8().constData());
+  w->flushSink();
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(ImageStreamWriter::RowsWritten) {
+  NanScope();
+
+  ImageStreamWriter* w = ObjectWrap::Unwrap<ImageStreamWriter>(args.This());
+
+  NanReturnValue(Integer::New(w->rows_));
+}
+
+// Returns false if the image was incomplete or could not be flushed
+NAN_METHOD(ImageStreamWriter::Close) {
+  NanScope();
+
+  ImageStreamWriter* w = ObjectWrap::Unwrap<ImageStreamWriter>(args.This());
+
+  if (w->closed_)
+    NanReturnValue(Boolean::New(false));
+  w->closed_ = true;
+
+  bool ok = w->finish();
+  w->flushSink();
+  w->device_->close();
+
+  NanReturnValue(Boolean::New(ok));
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IMAGESTREAMWRITER_H
+#define IMAGESTREAMWRITER_H
+
+#include <node.h>
+#include <QBuffer>
+#include <QImage>
+#include <QIODevice>
+#include <nan.h>
+#include "pngencoder.h"
+
+//
+// ImageStreamWriter
+// Writes an image strip by strip, so that images larger than memory can be
+// rendered and saved piecewise. Not a Qt class
+//
+class ImageStreamWriter : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+
+  enum Format { Png, Ppm, Raw };
+
+ private:
+  ImageStreamWriter(QIODevice* device, int width, int height, Format format,
+                    bool alpha, int compression);
+  ~ImageStreamWriter();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(Write);
+  static NAN_METHOD(RowsWritten);
+  static NAN_METHOD(Close);
+
+  bool begin();
+  bool writeRows(const QImage& strip);
+  bool finish();
+  void flushSink();
+
+  QIODevice* device_;
+  PngEncoder* png_;
+  Format format_;
+  int width_;
+  int height_;
+  int rows_;
+  bool closed_;
+  QString error_;
+
+  // Set when writing to a JS callback instead of a file; device_ is then
+  // a QBuffer drained after every call
+  v8::Persistent<v8::Function> sink_;
+};
+
+#endif
@@ -0,0 +1,444 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <node_buffer.h>
+#include <QApplication>
+#include <QDataStream>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include "../qt_v8.h"
+#include "../QtGui/qwidget.h"
+#include "imagebuffer.h"
+#include "inputlog.h"
+
+using namespace v8;
+
+// 'QILG', followed by a format version and the event count
+static const quint32 kMagic = 0x51494c47;
+static const quint16 kVersion = 2;
+static const size_t kHeaderSize = 4 + 2 + 4;
+// Serialized InputLogEvent, field by field
+static const size_t kRecordSize = 4 + 1 + 4 + 4 + 4 + 4 + 4 + 4 + 2;
+
+Persistent<Function> InputLog::constructor;
+
+InputLog::InputLog() : timeOffset_(0), speed_(1), next_(0) {
+}
+
+InputLog::~InputLog() {
+  NanDispose(replayCallback_);
+}
+
+void InputLog::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("InputLog"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("record"),
+      FunctionTemplate::New(Record)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("stop"),
+      FunctionTemplate::New(Stop)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("count"),
+      FunctionTemplate::New(Count)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("duration"),
+      FunctionTemplate::New(Duration)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("toBuffer"),
+      FunctionTemplate::New(ToBuffer)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("replay"),
+      FunctionTemplate::New(Replay)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("InputLog"), tpl->GetFunction());
+}
+
+// Supported implementations:
+//   InputLog ( )
+//   InputLog ( Buffer log )
+NAN_METHOD(InputLog::New) {
+  NanScope();
+
+  InputLog* w = new InputLog();
+
+  if (node::Buffer::HasInstance(args[0])) {
+    Local<Object> buffer = args[0]->ToObject();
+    if (!w->load(node::Buffer::Data(buffer), node::Buffer::Length(buffer))) {
+      delete w;
+      return NanThrowError("InputLog::InputLog: not a valid input log");
+    }
+  } else if (!args[0]->IsUndefined()) {
+    delete w;
+    return NanThrowTypeError("InputLog::InputLog: bad arguments");
+  }
+
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+bool InputLog::load(const char* data, size_t length) {
+  QByteArray bytes = QByteArray::fromRawData(data, length);
+  QDataStream in(bytes);
+  in.setByteOrder(QDataStream::LittleEndian);
+
+  quint32 magic, count;
+  quint16 version;
+  in >> magic >> version >> count;
+  if (in.status() != QDataStream::Ok || magic != kMagic ||
+      version != kVersion)
+    return false;
+
+  // count comes from the buffer; don't allocate for records that aren't there
+  if (length < kHeaderSize || count > (length - kHeaderSize) / kRecordSize)
+    return false;
+
+  events_.resize(count);
+  for (quint32 i = 0; i < count; ++i) {
+    InputLogEvent& e = events_[i];
+    in >> e.time >> e.type >> e.x >> e.y >> e.button >> e.buttons
+       >> e.modifiers >> e.key >> e.text;
+  }
+
+  if (in.status() != QDataStream::Ok) {
+    events_.clear();
+    return false;
+  }
+
+  return true;
+}
+
+QByteArray InputLog::save() const {
+  QByteArray bytes;
+  QDataStream out(&bytes, QIODevice::WriteOnly);
+  out.setByteOrder(QDataStream::LittleEndian);
+
+  out << kMagic << kVersion << quint32(events_.size());
+  for (int i = 0; i < events_.size(); ++i) {
+    const InputLogEvent& e = events_[i];
+    out << e.time << e.type << e.x << e.y << e.button << e.buttons
+        << e.modifiers << e.key << e.text;
+  }
+
+  return bytes;
+}
+
+// Only input aimed at the recorded widget itself is captured; children
+// receive their own events
+bool InputLog::eventFilter(QObject* watched, QEvent* e) {
+  if (watched != recording_)
+    return false;
+
+  InputLogEvent event;
+  memset(&event, 0, sizeof(event));
+  event.time = timeOffset_ + clock_.elapsed();
+  event.type = e->type();
+
+  switch (e->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove: {
+      QMouseEvent* m = static_cast<QMouseEvent*>(e);
+      event.x = m->x();
+      event.y = m->y();
+      event.button = m->button();
+      event.buttons = m->buttons();
+      event.modifiers = m->modifiers();
+      break;
+    }
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease: {
+      QKeyEvent* k = static_cast<QKeyEvent*>(e);
+      event.key = k->key();
+      event.modifiers = k->modifiers();
+      event.text = k->text().isEmpty() ? 0 : k->text()[0].unicode();
+      break;
+    }
+    case QEvent::Wheel: {
+      QWheelEvent* w = static_cast<QWheelEvent*>(e);
+      event.x = w->x();
+      event.y = w->y();
+      event.button = w->orientation();
+      event.buttons = w->buttons();
+      event.modifiers = w->modifiers();
+      event.key = w->delta();
+      break;
+    }
+    default:
+      return false;
+  }
+
+  events_.append(event);
+  return false;
+}
+
+void InputLog::timerEvent(QTimerEvent* e) {
+  if (e->timerId() == timer_.timerId())
+    replayNext();
+  else
+    QObject::timerEvent(e);
+}
+
+// Sends every event that is due, then sleeps until the next one. At
+// maximum speed (0) the whole log goes out in one go
+void InputLog::replayNext() {
+  timer_.stop();
+
+  if (!target_) {
+    finishReplay("InputLog::replay: widget was destroyed");
+    return;
+  }
+
+  qint64 now = clock_.elapsed();
+  while (next_ < events_.size()) {
+    const InputLogEvent& event = events_[next_];
+
+    if (speed_ > 0) {
+      qint64 due = (event.time - events_.first().time) / speed_;
+      if (due > now) {
+        timer_.start(due - now, this);
+        return;
+      }
+    }
+
+    inject(event);
+    next_++;
+
+    if (!target_) {
+      finishReplay("InputLog::replay: widget was destroyed");
+      return;
+    }
+  }
+
+  finishReplay(NULL);
+}
+
+// QUIRK:
+// Latency stops once the repaint request the event caused has been
+// processed. On platforms where update() doesn't go through
+// QEvent::UpdateRequest (Cocoa) it covers event handling only
+void InputLog::inject(const InputLogEvent& event) {
+  QElapsedTimer t;
+  t.start();
+
+  Qt::KeyboardModifiers modifiers(event.modifiers);
+
+  switch (event.type) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove: {
+      QPoint pos(event.x, event.y);
+      QMouseEvent e(QEvent::Type(event.type), pos, target_->mapToGlobal(pos),
+                    Qt::MouseButton(event.button),
+                    Qt::MouseButtons(event.buttons), modifiers);
+      QApplication::sendEvent(target_, &e);
+      break;
+    }
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease: {
+      QString text = event.text ? QString(QChar(event.text)) : QString();
+      QKeyEvent e(QEvent::Type(event.type), event.key, modifiers, text);
+      QApplication::sendEvent(target_, &e);
+      break;
+    }
+    case QEvent::Wheel: {
+      QPoint pos(event.x, event.y);
+      QWheelEvent e(pos, target_->mapToGlobal(pos), event.key,
+                    Qt::MouseButtons(event.buttons), modifiers,
+                    Qt::Orientation(event.button));
+      QApplication::sendEvent(target_, &e);
+      break;
+    }
+    default:
+      break;
+  }
+
+  if (target_)
+    QApplication::sendPostedEvents(target_->window(), QEvent::UpdateRequest);
+
+  latencies_.append(t.nsecsElapsed() / 1e6);
+}
+
+// Calls back with (error, stats)
+void InputLog::finishReplay(const char* error) {
+  NanScope();
+
+  double elapsed = clock_.elapsed();
+  double total = 0, max = 0;
+  Local<Array> latencies = Array::New(latencies_.size());
+  for (int i = 0; i < latencies_.size(); ++i) {
+    latencies->Set(i, Number::New(latencies_[i]));
+    total += latencies_[i];
+    max = qMax(max, latencies_[i]);
+  }
+
+  Local<Object> stats = Object::New();
+  stats->Set(String::NewSymbol("count"), Integer::New(latencies_.size()));
+  stats->Set(String::NewSymbol("elapsed"), Number::New(elapsed));
+  stats->Set(String::NewSymbol("latencies"), latencies);
+  stats->Set(String::NewSymbol("mean"),
+      Number::New(latencies_.isEmpty() ? 0 : total / latencies_.size()));
+  stats->Set(String::NewSymbol("max"), Number::New(max));
+
+  Local<Function> cb = NanPersistentToLocal(replayCallback_);
+  NanDispose(replayCallback_);
+  target_ = NULL;
+  latencies_.clear();
+
+  const unsigned argc = 2;
+  Handle<Value> argv[argc] = {
+    error ? Exception::Error(String::New(error)) : Local<Value>::New(Null()),
+    stats
+  };
+
+  // The replay kept us alive until now
+  Unref();
+
+  cb->Call(Context::GetCurrent()->Global(), argc, argv);
+}
+
+// Records input sent to the widget until stop(), appending to the log
+NAN_METHOD(InputLog::Record) {
+  NanScope();
+
+  InputLog* w = ObjectWrap::Unwrap<InputLog>(args.This());
+
+  if (!args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QWidget")
+    return NanThrowTypeError("InputLog::record: bad arguments");
+
+  if (!w->replayCallback_.IsEmpty())
+    return NanThrowError("InputLog::record: replay in progress");
+
+  QWidget* widget = node::ObjectWrap::Unwrap<QWidgetWrap>(
+      args[0]->ToObject())->GetWrapped();
+
+  if (w->recording_)
+    w->recording_->removeEventFilter(w);
+
+  // Timings continue from the end of what is already in the log
+  w->timeOffset_ = w->events_.isEmpty() ? 0 : w->events_.last().time;
+  w->clock_.start();
+  w->recording_ = widget;
+  widget->installEventFilter(w);
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(InputLog::Stop) {
+  NanScope();
+
+  InputLog* w = ObjectWrap::Unwrap<InputLog>(args.This());
+
+  if (w->recording_)
+    w->recording_->removeEventFilter(w);
+  w->recording_ = NULL;
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(InputLog::Count) {
+  NanScope();
+
+  InputLog* w = ObjectWrap::Unwrap<InputLog>(args.This());
+
+  NanReturnValue(Integer::New(w->events_.size()));
+}
+
+// Milliseconds between the first and last event
+NAN_METHOD(InputLog::Duration) {
+  NanScope();
+
+  InputLog* w = ObjectWrap::Unwrap<InputLog>(args.This());
+
+  if (w->events_.isEmpty())
+    NanReturnValue(Integer::New(0));
+
+  NanReturnValue(Number::New(w->events_.last().time -
+                             w->events_.first().time));
+}
+
+NAN_METHOD(InputLog::ToBuffer) {
+  NanScope();
+
+  InputLog* w = ObjectWrap::Unwrap<InputLog>(args.This());
+
+  NanReturnValue(ImageBuffer::toBuffer(new QByteArray(w->save())));
+}
+
+// Supported versions:
+//   replay(QWidget widget, Function callback)
+//   replay(QWidget widget, { speed: Number }, Function callback)
+//
+// speed is a multiplier of the recorded timings (default 1); 0 replays as
+// fast as possible. The application must keep calling processEvents()
+NAN_METHOD(InputLog::Replay) {
+  NanScope();
+
+  InputLog* w = ObjectWrap::Unwrap<InputLog>(args.This());
+
+  int cbIndex = args[1]->IsFunction() ? 1 : 2;
+  if (!args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QWidget" ||
+      !args[cbIndex]->IsFunction())
+    return NanThrowTypeError("InputLog::replay: bad arguments");
+
+  double speed = 1;
+  if (cbIndex == 2 && args[1]->IsObject()) {
+    Local<Value> option = args[1]->ToObject()->Get(String::NewSymbol("speed"));
+    if (!option->IsUndefined())
+      speed = option->NumberValue();
+  }
+  if (speed < 0)
+    return NanThrowRangeError("InputLog::replay: speed must not be negative");
+
+  if (!w->replayCallback_.IsEmpty())
+    return NanThrowError("InputLog::replay: replay in progress");
+  if (w->recording_)
+    return NanThrowError("InputLog::replay: recording in progress");
+
+  w->target_ = node::ObjectWrap::Unwrap<QWidgetWrap>(
+      args[0]->ToObject())->GetWrapped();
+  w->speed_ = speed;
+  w->next_ = 0;
+  w->latencies_.clear();
+  w->latencies_.reserve(w->events_.size());
+  NanAssignPersistent(Function, w->replayCallback_,
+                      Local<Function>::Cast(args[cbIndex]));
+
+  // Stay alive while the timer may still fire
+  w->Ref();
+  w->clock_.start();
+  w->timer_.start(0, w);
+
+  NanReturnUndefined();
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <node.h>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include <QWidget>
+#include <nan.h>
+
+//
+// InputLogEvent
+// One recorded mouse, key or wheel event, as stored in the binary log
+//
+struct InputLogEvent {
+  quint32 time;       // ms since recording started
+  quint8 type;        // QEvent::Type
+  qint32 x, y;        // widget coordinates
+  quint32 button;     // mouse button, or wheel orientation
+  quint32 buttons;
+  quint32 modifiers;
+  qint32 key;         // key code, or wheel delta
+  quint16 text;       // first UTF-16 unit of the key's text
+};
+
+//
+// InputLog
+// Records the input a widget receives (positions, timings, modifiers) to a
+// compact binary log and replays it against a widget at 1x, Nx or maximum
+// speed, measuring each event from injection until the repaint it caused
+// has completed. Replay runs off Qt's event loop on our own timer. Not a Qt
+// class
+//
+class InputLog : public QObject, public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+
+ protected:
+  bool eventFilter(QObject* watched, QEvent* e);
+  void timerEvent(QTimerEvent* e);
+
+ private:
+  InputLog();
+  ~InputLog();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(Record);
+  static NAN_METHOD(Stop);
+  static NAN_METHOD(Count);
+  static NAN_METHOD(Duration);
+  static NAN_METHOD(ToBuffer);
+  static NAN_METHOD(Replay);
+
+  bool load(const char* data, size_t length);
+  QByteArray save() const;
+
+  void replayNext();
+  void inject(const InputLogEvent& event);
+  void finishReplay(const char* error);
+
+  QVector<InputLogEvent> events_;
+  QPointer<QWidget> recording_;
+  QElapsedTimer clock_;
+  quint32 timeOffset_;
+
+  QPointer<QWidget> target_;
+  QBasicTimer timer_;
+  double speed_;
+  int next_;
+  QVector<double> latencies_;
+  v8::Persistent<v8::Function> replayCallback_;
+};
+
+#endif
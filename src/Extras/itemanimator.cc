@@ -0,0 +1,149 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <QTimerEvent>
+#include "itemanimator.h"
+
+// ~60 frames per second
+static const int kFrameInterval = 16;
+
+ItemAnimator* ItemAnimator::instance() {
+  static ItemAnimator* animator = new ItemAnimator;
+  return animator;
+}
+
+ItemAnimator::ItemAnimator() {
+  clock_.start();
+}
+
+void ItemAnimator::start(QGraphicsItem* item, Property property,
+                         const Keyframes& keys, int duration,
+                         const QEasingCurve& easing, int loops) {
+  stop(item, property);
+
+  Animation a;
+  a.item = item;
+  a.property = property;
+  a.keys = keys;
+  a.easing = easing;
+  a.start = clock_.elapsed();
+  a.duration = qMax(duration, 1);
+  a.loops = loops;
+  animations_.append(a);
+
+  // First frame now, so nothing is drawn at the old value
+  apply(a, 0);
+
+  if (!timer_.isActive())
+    timer_.start(kFrameInterval, this);
+}
+
+void ItemAnimator::stop(QGraphicsItem* item, int property) {
+  for (int i = animations_.size() - 1; i >= 0; --i) {
+    const Animation& a = animations_[i];
+    if (a.item == item && (property < 0 || a.property == property))
+      animations_.remove(i);
+  }
+
+  if (animations_.isEmpty())
+    timer_.stop();
+}
+
+bool ItemAnimator::isAnimating(QGraphicsItem* item) const {
+  for (int i = 0; i < animations_.size(); ++i)
+    if (animations_[i].item == item)
+      return true;
+  return false;
+}
+
+qreal ItemAnimator::value(QGraphicsItem* item, Property property) {
+  switch (property) {
+    case X: return item->x();
+    case Y: return item->y();
+    case Rotation: return item->rotation();
+    case Scale: return item->scale();
+    case Opacity: return item->opacity();
+    case ZValue: return item->zValue();
+  }
+  return 0;
+}
+
+// Easing runs over the whole timeline, then the eased progress is
+// interpolated between the keyframes around it, as QVariantAnimation does
+void ItemAnimator::apply(const Animation& a, qreal progress) {
+  qreal t = a.easing.valueForProgress(progress);
+  const Keyframes& keys = a.keys;
+
+  int next = 1;
+  while (next < keys.size() - 1 && keys[next].first < t)
+    ++next;
+
+  const QPair<qreal, qreal>& from = keys[next - 1];
+  const QPair<qreal, qreal>& to = keys[next];
+  qreal span = to.first - from.first;
+  qreal local = span > 0 ? (t - from.first) / span : 1;
+  qreal v = from.second + (to.second - from.second) * local;
+
+  QGraphicsItem* item = a.item;
+  switch (a.property) {
+    case X: item->setX(v); break;
+    case Y: item->setY(v); break;
+    case Rotation: item->setRotation(v); break;
+    case Scale: item->setScale(v); break;
+    case Opacity: item->setOpacity(v); break;
+    case ZValue: item->setZValue(v); break;
+  }
+}
+
+void ItemAnimator::timerEvent(QTimerEvent* e) {
+  if (e->timerId() != timer_.timerId()) {
+    QObject::timerEvent(e);
+    return;
+  }
+
+  qint64 now = clock_.elapsed();
+
+  for (int i = animations_.size() - 1; i >= 0; --i) {
+    Animation& a = animations_[i];
+    qint64 elapsed = now - a.start;
+    qint64 loop = elapsed / a.duration;
+
+    if (a.loops >= 0 && loop >= a.loops) {
+      // Land exactly on the last keyframe
+      apply(a, 1);
+      animations_.remove(i);
+      continue;
+    }
+
+    apply(a, qreal(elapsed % a.duration) / a.duration);
+  }
+
+  if (animations_.isEmpty())
+    timer_.stop();
+}
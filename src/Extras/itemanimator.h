@@ -0,0 +1,91 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ITEMANIMATOR_H
+#define ITEMANIMATOR_H
+
+#include <QBasicTimer>
+#include <QEasingCurve>
+#include <QElapsedTimer>
+#include <QGraphicsItem>
+#include <QObject>
+#include <QPair>
+#include <QVector>
+
+//
+// ItemAnimator
+// Timeline engine for graphics item animations configured from JS
+// (QGraphicsItem.animate()). One timer ticks every running animation and
+// sets the item properties natively; the scene then repaints what moved.
+// No JS runs per frame. QPropertyAnimation needs QObject targets, which
+// scene items are not. Not a Qt class, and not exposed to JS
+//
+class ItemAnimator : public QObject {
+ public:
+  enum Property { X, Y, Rotation, Scale, Opacity, ZValue };
+
+  // (progress 0..1, value) pairs, progress ascending
+  typedef QVector<QPair<qreal, qreal> > Keyframes;
+
+  static ItemAnimator* instance();
+
+  // Replaces any animation of the same item and property. loops < 0
+  // repeats forever
+  void start(QGraphicsItem* item, Property property, const Keyframes& keys,
+             int duration, const QEasingCurve& easing, int loops);
+  // Stops the item's animations of property, or all of them if < 0
+  void stop(QGraphicsItem* item, int property);
+  bool isAnimating(QGraphicsItem* item) const;
+
+  static qreal value(QGraphicsItem* item, Property property);
+
+ protected:
+  void timerEvent(QTimerEvent* e);
+
+ private:
+  ItemAnimator();
+
+  struct Animation {
+    QGraphicsItem* item;
+    Property property;
+    Keyframes keys;
+    QEasingCurve easing;
+    qint64 start;
+    int duration;
+    int loops;
+  };
+
+  static void apply(const Animation& a, qreal progress);
+
+  QVector<Animation> animations_;
+  QBasicTimer timer_;
+  QElapsedTimer clock_;
+};
+
+#endif
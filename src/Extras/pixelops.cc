@@ -0,0 +1,119 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "pixelops.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+#ifndef __SSE2__
+inline int clamp255(float v) {
+  int i = (int)(v + 0.5f);
+  return i < 0 ? 0 : (i > 255 ? 255 : i);
+}
+
+void colorMatrixScalar(QRgb* pixels, int count, const float* m) {
+  for (int i = 0; i < count; ++i) {
+    QRgb p = pixels[i];
+    float r = qRed(p), g = qGreen(p), b = qBlue(p), a = qAlpha(p);
+    pixels[i] = qRgba(
+        clamp255(m[0] * r + m[1] * g + m[2] * b + m[3] * a + m[4]),
+        clamp255(m[5] * r + m[6] * g + m[7] * b + m[8] * a + m[9]),
+        clamp255(m[10] * r + m[11] * g + m[12] * b + m[13] * a + m[14]),
+        clamp255(m[15] * r + m[16] * g + m[17] * b + m[18] * a + m[19]));
+  }
+}
+#else
+// SSE2 is baseline on every x86-64 target we build for, so there's no
+// runtime dispatch. Pixels are BGRA in memory (x86 is little-endian); each
+// one is widened to four floats and multiplied by the matrix columns,
+// rearranged to match that lane order
+void colorMatrixSSE2(QRgb* pixels, int count, const float* m) {
+  // Column c holds the contribution of input channel c to output (b,g,r,a)
+  __m128 colB = _mm_setr_ps(m[12], m[7], m[2], m[17]);
+  __m128 colG = _mm_setr_ps(m[11], m[6], m[1], m[16]);
+  __m128 colR = _mm_setr_ps(m[10], m[5], m[0], m[15]);
+  __m128 colA = _mm_setr_ps(m[13], m[8], m[3], m[18]);
+  __m128 offset = _mm_setr_ps(m[14], m[9], m[4], m[19]);
+  __m128i zero = _mm_setzero_si128();
+
+  for (int i = 0; i < count; ++i) {
+    __m128i p = _mm_cvtsi32_si128(pixels[i]);
+    p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(p, zero), zero);
+    __m128 v = _mm_cvtepi32_ps(p);
+
+    __m128 out = _mm_add_ps(offset,
+        _mm_mul_ps(colB, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0))));
+    out = _mm_add_ps(out,
+        _mm_mul_ps(colG, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    out = _mm_add_ps(out,
+        _mm_mul_ps(colR, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    out = _mm_add_ps(out,
+        _mm_mul_ps(colA, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+
+    // Round, then saturate down to 8 bits per channel
+    __m128i o = _mm_cvtps_epi32(out);
+    o = _mm_packs_epi32(o, o);
+    o = _mm_packus_epi16(o, o);
+    pixels[i] = _mm_cvtsi128_si32(o);
+  }
+}
+#endif
+
+}
+
+void PixelOps::colorMatrix(QImage& image, const float matrix[20]) {
+  if (image.isNull())
+    return;
+
+  // Work in 0..255 units; offsets are given in 0..1
+  float m[20];
+  for (int i = 0; i < 20; ++i)
+    m[i] = (i % 5 == 4) ? matrix[i] * 255.0f : matrix[i];
+
+  QImage::Format format = image.format();
+  QImage work = format == QImage::Format_ARGB32 ?
+      image : image.convertToFormat(QImage::Format_ARGB32);
+  work.detach();
+
+  for (int y = 0; y < work.height(); ++y) {
+    QRgb* row = (QRgb*)work.scanLine(y);
+#ifdef __SSE2__
+    colorMatrixSSE2(row, work.width(), m);
+#else
+    colorMatrixScalar(row, work.width(), m);
+#endif
+  }
+
+  image = format == QImage::Format_ARGB32 ?
+      work : work.convertToFormat(format);
+}
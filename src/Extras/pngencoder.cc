@@ -0,0 +1,421 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdlib>
+#include <QList>
+#include <QRunnable>
+#include <QThreadPool>
+#include "pngencoder.h"
+
+// Size of the deflate output buffer, and so of each IDAT chunk
+static const int kChunkSize = 64 * 1024;
+
+// Uncompressed bytes per parallel deflate job, and the deflate window
+static const int kJobSize = 128 * 1024;
+static const int kWindowSize = 32 * 1024;
+
+static void putUInt32(char* p, quint32 v) {
+  p[0] = (v >> 24) & 0xff;
+  p[1] = (v >> 16) & 0xff;
+  p[2] = (v >> 8) & 0xff;
+  p[3] = v & 0xff;
+}
+
+// Converts one scanline of an ARGB32/RGB32 image to PNG's RGB(A) bytes
+static void packRow(const QRgb* src, int width, bool alpha, uchar* dst) {
+  for (int x = 0; x < width; ++x) {
+    *dst++ = qRed(src[x]);
+    *dst++ = qGreen(src[x]);
+    *dst++ = qBlue(src[x]);
+    if (alpha)
+      *dst++ = qAlpha(src[x]);
+  }
+}
+
+static inline uchar paeth(int a, int b, int c) {
+  int p = a + b - c;
+  int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+  if (pa <= pb && pa <= pc)
+    return a;
+  return pb <= pc ? b : c;
+}
+
+// Filters raw (length bytes, bpp bytes per pixel) against the previous
+// row prior into out, which receives the filter type byte first
+static void filterRow(PngEncoder::Filter filter, const uchar* raw,
+                      const uchar* prior, int length, int bpp, uchar* out) {
+  if (filter == PngEncoder::FilterAdaptive) {
+    // Keep whichever filter gives the smallest sum of absolute values,
+    // reading the filtered bytes as signed
+    QByteArray candidate(length + 1, 0);
+    uchar* c = (uchar*)candidate.data();
+    long best = -1;
+    for (int f = PngEncoder::FilterNone; f <= PngEncoder::FilterPaeth; ++f) {
+      filterRow((PngEncoder::Filter)f, raw, prior, length, bpp, c);
+      long sum = 0;
+      for (int i = 1; i <= length; ++i)
+        sum += abs((signed char)c[i]);
+      if (best < 0 || sum < best) {
+        best = sum;
+        memcpy(out, c, length + 1);
+      }
+    }
+    return;
+  }
+
+  *out++ = filter;
+  for (int i = 0; i < length; ++i) {
+    int a = i >= bpp ? raw[i - bpp] : 0;
+    int b = prior[i];
+    int c = i >= bpp ? prior[i - bpp] : 0;
+    switch (filter) {
+      case PngEncoder::FilterSub: out[i] = raw[i] - a; break;
+      case PngEncoder::FilterUp: out[i] = raw[i] - b; break;
+      case PngEncoder::FilterAverage: out[i] = raw[i] - ((a + b) >> 1); break;
+      case PngEncoder::FilterPaeth: out[i] = raw[i] - paeth(a, b, c); break;
+      default: out[i] = raw[i]; break;
+    }
+  }
+}
+
+//
+// DeflateJob
+// One chunk of rows for PngEncoder::encode(), deflated by a DeflateTask
+// as a raw stream that ends on a byte boundary so the chunks can be
+// concatenated
+//
+struct DeflateJob {
+  int first;
+  int last;
+  QByteArray out;
+  uLong adler;
+  uLong length;
+  bool ok;
+};
+
+class DeflateTask : public QRunnable {
+ public:
+  DeflateTask(const QImage* image, bool alpha, int compression,
+              PngEncoder::Filter filter, DeflateJob* job)
+      : image_(image), alpha_(alpha), compression_(compression),
+        filter_(filter), job_(job) {}
+
+  void run() {
+    DeflateJob& job = *job_;
+    int width = image_->width();
+    int bpp = alpha_ ? 4 : 3;
+    int length = width * bpp;
+
+    // Filtered rows from first - back to last; the ones before first only
+    // prime the dictionary
+    int back = qMin(job.first, (kWindowSize + length) / (length + 1));
+    int start = job.first - back;
+    QByteArray filtered((job.last - start) * (length + 1), 0);
+    QByteArray raw(length, 0), prior(length, 0);
+
+    if (start > 0)
+      packRow((const QRgb*)image_->constScanLine(start - 1), width, alpha_,
+              (uchar*)prior.data());
+    for (int y = start; y < job.last; ++y) {
+      packRow((const QRgb*)image_->constScanLine(y), width, alpha_,
+              (uchar*)raw.data());
+      filterRow(filter_, (const uchar*)raw.constData(),
+                (const uchar*)prior.constData(), length, bpp,
+                (uchar*)filtered.data() + (y - start) * (length + 1));
+      qSwap(raw, prior);
+    }
+
+    int skip = back * (length + 1);
+    const Bytef* data = (const Bytef*)filtered.constData() + skip;
+    job.length = filtered.size() - skip;
+    job.adler = adler32(adler32(0L, Z_NULL, 0), data, job.length);
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    job.ok = deflateInit2(&stream, compression_, Z_DEFLATED, -15, 8,
+                          Z_DEFAULT_STRATEGY) == Z_OK;
+    if (!job.ok)
+      return;
+
+    if (skip > 0) {
+      int dict = qMin(skip, kWindowSize);
+      deflateSetDictionary(&stream, data - dict, dict);
+    }
+
+    job.out.resize(deflateBound(&stream, job.length) + 16);
+    stream.next_in = (Bytef*)data;
+    stream.avail_in = job.length;
+    stream.next_out = (Bytef*)job.out.data();
+    stream.avail_out = job.out.size();
+
+    // The last chunk closes the stream; the others stop on a byte boundary
+    int flush = job.last == image_->height() ? Z_FINISH : Z_SYNC_FLUSH;
+    int ret = deflate(&stream, flush);
+    job.ok = flush == Z_FINISH ? ret == Z_STREAM_END : ret == Z_OK;
+    job.out.resize(job.out.size() - stream.avail_out);
+    deflateEnd(&stream);
+  }
+
+ private:
+  const QImage* image_;
+  bool alpha_;
+  int compression_;
+  PngEncoder::Filter filter_;
+  DeflateJob* job_;
+};
+
+PngEncoder::PngEncoder(QIODevice* device, int width, int height, bool alpha,
+                       int compression)
+    : device_(device), width_(width), height_(height), alpha_(alpha),
+      compression_(compression), filter_(FilterNone), rows_(0),
+      started_(false), pending_(0) {
+  stream_.zalloc = Z_NULL;
+  stream_.zfree = Z_NULL;
+  stream_.opaque = Z_NULL;
+}
+
+PngEncoder::~PngEncoder() {
+  if (started_)
+    deflateEnd(&stream_);
+}
+
+bool PngEncoder::fail(const QString& error) {
+  error_ = error;
+  return false;
+}
+
+bool PngEncoder::begin() {
+  if (width_ <= 0 || height_ <= 0)
+    return fail("PngEncoder: bad image size");
+
+  if (deflateInit(&stream_, qBound(0, compression_, 9)) != Z_OK)
+    return fail("PngEncoder: deflateInit failed");
+  started_ = true;
+
+  out_.resize(kChunkSize);
+  row_.resize(1 + width_ * (alpha_ ? 4 : 3));
+  raw_.resize(width_ * (alpha_ ? 4 : 3));
+  prior_.fill(0, raw_.size());
+
+  static const char signature[8] = {
+    (char)0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'
+  };
+  if (device_->write(signature, 8) != 8)
+    return fail(device_->errorString());
+
+  char ihdr[13];
+  putUInt32(ihdr, width_);
+  putUInt32(ihdr + 4, height_);
+  ihdr[8] = 8;                // bit depth
+  ihdr[9] = alpha_ ? 6 : 2;   // color type: RGBA or RGB
+  ihdr[10] = 0;               // deflate
+  ihdr[11] = 0;               // adaptive filtering
+  ihdr[12] = 0;               // no interlace
+
+  return writeChunk("IHDR", ihdr, 13);
+}
+
+bool PngEncoder::writeRows(const QImage& strip) {
+  if (!started_)
+    return fail("PngEncoder: begin() not called");
+  if (strip.width() != width_)
+    return fail("PngEncoder: strip width does not match image width");
+  if (rows_ + strip.height() > height_)
+    return fail("PngEncoder: too many rows");
+
+  QImage argb = strip.convertToFormat(alpha_ ? QImage::Format_ARGB32 :
+                                               QImage::Format_RGB32);
+
+  uchar* row = (uchar*)row_.data();
+  for (int y = 0; y < argb.height(); ++y) {
+    packRow((const QRgb*)argb.constScanLine(y), width_, alpha_,
+            (uchar*)raw_.data());
+    filterRow(filter_, (const uchar*)raw_.constData(),
+              (const uchar*)prior_.constData(), raw_.size(),
+              alpha_ ? 4 : 3, row);
+    qSwap(raw_, prior_);
+
+    if (!deflateData(row, row_.size(), Z_NO_FLUSH))
+      return false;
+    ++rows_;
+  }
+
+  return true;
+}
+
+bool PngEncoder::finish() {
+  if (!started_)
+    return fail("PngEncoder: begin() not called");
+  if (rows_ != height_)
+    return fail("PngEncoder: image is incomplete");
+
+  if (!deflateData(NULL, 0, Z_FINISH))
+    return false;
+
+  return writeChunk("IEND", NULL, 0);
+}
+
+// Feeds data to the deflate stream, emitting an IDAT chunk every time the
+// output buffer fills up, and for whatever is left when finishing
+bool PngEncoder::deflateData(const uchar* data, int length, int flush) {
+  stream_.next_in = (Bytef*)data;
+  stream_.avail_in = length;
+
+  for (;;) {
+    stream_.next_out = (Bytef*)out_.data() + pending_;
+    stream_.avail_out = kChunkSize - pending_;
+
+    int ret = deflate(&stream_, flush);
+    if (ret == Z_STREAM_ERROR)
+      return fail("PngEncoder: deflate failed");
+
+    pending_ = kChunkSize - stream_.avail_out;
+
+    if (pending_ == kChunkSize || (flush == Z_FINISH && pending_ > 0)) {
+      if (!writeChunk("IDAT", out_.constData(), pending_))
+        return false;
+      pending_ = 0;
+    }
+
+    if (flush == Z_FINISH) {
+      if (ret == Z_STREAM_END)
+        break;
+    } else if (stream_.avail_in == 0 && stream_.avail_out != 0) {
+      break;
+    }
+  }
+
+  return true;
+}
+
+bool PngEncoder::writeChunk(const char* type, const char* data, int length) {
+  char header[8];
+  putUInt32(header, length);
+  memcpy(header + 4, type, 4);
+
+  uLong crc = crc32(0L, Z_NULL, 0);
+  crc = crc32(crc, (const Bytef*)type, 4);
+  if (length > 0)
+    crc = crc32(crc, (const Bytef*)data, length);
+
+  char footer[4];
+  putUInt32(footer, crc);
+
+  if (device_->write(header, 8) != 8 ||
+      (length > 0 && device_->write(data, length) != length) ||
+      device_->write(footer, 4) != 4)
+    return fail(device_->errorString());
+
+  return true;
+}
+
+bool PngEncoder::encode(QIODevice* device, const QImage& image,
+                        int compression, Filter filter, int threads,
+                        QString* error) {
+  bool alpha = image.hasAlphaChannel();
+  compression = qBound(0, compression, 9);
+  PngEncoder encoder(device, image.width(), image.height(), alpha,
+                     compression);
+  encoder.setFilter(filter);
+
+  if (threads <= 1) {
+    bool ok = encoder.begin() && encoder.writeRows(image) && encoder.finish();
+    if (!ok && error)
+      *error = encoder.errorString();
+    return ok;
+  }
+
+  if (!encoder.begin()) {
+    if (error) *error = encoder.errorString();
+    return false;
+  }
+
+  // Converted once up front: the jobs only read it
+  QImage argb = image.convertToFormat(alpha ? QImage::Format_ARGB32 :
+                                              QImage::Format_RGB32);
+  int rowBytes = 1 + image.width() * (alpha ? 4 : 3);
+  int rowsPerJob = qMax(1, kJobSize / rowBytes);
+
+  QList<DeflateJob> jobs;
+  for (int y = 0; y < argb.height(); y += rowsPerJob) {
+    DeflateJob job;
+    job.first = y;
+    job.last = qMin(argb.height(), y + rowsPerJob);
+    job.adler = 1;
+    job.length = 0;
+    job.ok = false;
+    jobs.append(job);
+  }
+
+  // A private pool, so threads caps this encode without touching the
+  // global pool's size
+  QThreadPool pool;
+  pool.setMaxThreadCount(threads);
+  for (int i = 0; i < jobs.size(); ++i)
+    pool.start(new DeflateTask(&argb, alpha, compression, filter, &jobs[i]));
+  pool.waitForDone();
+
+  // zlib header, FLEVEL matching the compression level
+  static const char levels[4] = { 0x01, 0x5e, (char)0x9c, (char)0xda };
+  QByteArray stream;
+  stream.append((char)0x78);
+  stream.append(levels[compression < 2 ? 0 : compression < 6 ? 1 :
+                       compression == 6 ? 2 : 3]);
+
+  uLong adler = adler32(0L, Z_NULL, 0);
+  for (int i = 0; i < jobs.size(); ++i) {
+    if (!jobs[i].ok) {
+      if (error) *error = "PngEncoder: deflate failed";
+      return false;
+    }
+    stream.append(jobs[i].out);
+    adler = adler32_combine(adler, jobs[i].adler, jobs[i].length);
+  }
+
+  char trailer[4];
+  putUInt32(trailer, adler);
+  stream.append(trailer, 4);
+
+  for (int offset = 0; offset < stream.size(); offset += kChunkSize) {
+    int length = qMin(kChunkSize, stream.size() - offset);
+    if (!encoder.writeChunk("IDAT", stream.constData() + offset, length)) {
+      if (error) *error = encoder.errorString();
+      return false;
+    }
+  }
+
+  if (!encoder.writeChunk("IEND", NULL, 0)) {
+    if (error) *error = encoder.errorString();
+    return false;
+  }
+
+  return true;
+}
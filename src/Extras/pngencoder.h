@@ -0,0 +1,105 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PNGENCODER_H
+#define PNGENCODER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QIODevice>
+#include <QString>
+#include <zlib.h>
+
+//
+// PngEncoder
+// Incremental PNG encoder. Rows are filtered, deflated and flushed to the
+// device as IDAT chunks as they arrive, so memory use is bounded by the
+// strip being written rather than by the whole image
+//
+class PngEncoder {
+ public:
+  // Per-row filter types; Adaptive picks the best of the others for every
+  // row (minimum sum of absolute differences, as libpng does)
+  enum Filter {
+    FilterNone = 0,
+    FilterSub = 1,
+    FilterUp = 2,
+    FilterAverage = 3,
+    FilterPaeth = 4,
+    FilterAdaptive = 5
+  };
+
+  PngEncoder(QIODevice* device, int width, int height, bool alpha,
+             int compression = 6);
+  ~PngEncoder();
+
+  // Encodes a whole image in one go. With threads > 1 the rows are split
+  // into ~128KB chunks that are filtered and deflated concurrently, each
+  // primed with the previous chunk's last 32KB (as pigz does), so the
+  // output stays a single valid zlib stream. Safe to call from any thread
+  static bool encode(QIODevice* device, const QImage& image, int compression,
+                     Filter filter, int threads, QString* error);
+
+  // Takes effect from the next row written. Default is FilterNone
+  void setFilter(Filter filter) { filter_ = filter; };
+
+  // Writes the signature and IHDR. Must be called before writeRows()
+  bool begin();
+  // Appends strip's rows; strip.width() must equal the image width
+  bool writeRows(const QImage& strip);
+  // Flushes the deflate stream and writes IEND
+  bool finish();
+
+  int rowsWritten() const { return rows_; };
+  QString errorString() const { return error_; };
+
+ private:
+  bool deflateData(const uchar* data, int length, int flush);
+  bool writeChunk(const char* type, const char* data, int length);
+  bool fail(const QString& error);
+
+  QIODevice* device_;
+  int width_;
+  int height_;
+  bool alpha_;
+  int compression_;
+  Filter filter_;
+  int rows_;
+  bool started_;
+  QString error_;
+
+  z_stream stream_;
+  QByteArray out_;
+  int pending_;
+  QByteArray row_;
+  QByteArray raw_;
+  QByteArray prior_;
+};
+
+#endif
@@ -0,0 +1,148 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <QFile>
+#include <QThread>
+#include "../qt_v8.h"
+#include "pngsave.h"
+
+using namespace v8;
+
+namespace {
+
+//
+// PngSaveWorker
+// The image is an implicitly shared copy, converted (for QPixmap) on the
+// main thread before queueing
+//
+class PngSaveWorker : public NanAsyncWorker {
+ public:
+  PngSaveWorker(NanCallback* callback, const QImage& image,
+                const QString& file, const PngSave::Options& options)
+      : NanAsyncWorker(callback), image_(image), file_(file),
+        options_(options) {}
+
+  void Execute() {
+    ok_ = PngSave::save(image_, file_, options_, &error_);
+  }
+
+  void HandleOKCallback() {
+    NanScope();
+
+    Local<Value> argv[1];
+    if (ok_)
+      argv[0] = Local<Value>::New(Null());
+    else
+      argv[0] = Exception::Error(qt_v8::FromQString(error_));
+    callback->Run(1, argv);
+  }
+
+ private:
+  QImage image_;
+  QString file_;
+  PngSave::Options options_;
+  bool ok_;
+  QString error_;
+};
+
+}
+
+bool PngSave::parseOptions(Handle<Value> value, Options* options,
+                           QString* error) {
+  options->compression = 6;
+  options->filter = PngEncoder::FilterAdaptive;
+  options->threads = QThread::idealThreadCount();
+
+  if (value->IsUndefined())
+    return true;
+  if (!value->IsObject()) {
+    *error = "bad options";
+    return false;
+  }
+
+  Local<Object> object = value->ToObject();
+  Local<Value> compression = object->Get(String::NewSymbol("compression"));
+  if (compression->IsNumber()) {
+    options->compression = compression->IntegerValue();
+    if (options->compression < 0 || options->compression > 9) {
+      *error = "compression must be 0-9";
+      return false;
+    }
+  }
+
+  Local<Value> filter = object->Get(String::NewSymbol("filter"));
+  if (filter->IsString()) {
+    QString name = qt_v8::ToQString(filter->ToString()).toLower();
+    if (name == "none")
+      options->filter = PngEncoder::FilterNone;
+    else if (name == "sub")
+      options->filter = PngEncoder::FilterSub;
+    else if (name == "up")
+      options->filter = PngEncoder::FilterUp;
+    else if (name == "average")
+      options->filter = PngEncoder::FilterAverage;
+    else if (name == "paeth")
+      options->filter = PngEncoder::FilterPaeth;
+    else if (name == "adaptive")
+      options->filter = PngEncoder::FilterAdaptive;
+    else {
+      *error = "unknown filter";
+      return false;
+    }
+  }
+
+  Local<Value> threads = object->Get(String::NewSymbol("threads"));
+  if (threads->IsNumber())
+    options->threads = qMax(1, (int)threads->IntegerValue());
+
+  return true;
+}
+
+bool PngSave::save(const QImage& image, const QString& file,
+                   const Options& options, QString* error) {
+  if (image.isNull()) {
+    *error = "image is null";
+    return false;
+  }
+
+  QFile device(file);
+  if (!device.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    *error = device.errorString();
+    return false;
+  }
+
+  return PngEncoder::encode(&device, image, options.compression,
+                            options.filter, options.threads, error);
+}
+
+void PngSave::saveAsync(const QImage& image, const QString& file,
+                        const Options& options, Local<Function> callback) {
+  NanAsyncQueueWorker(new PngSaveWorker(new NanCallback(callback), image,
+                                        file, options));
+}
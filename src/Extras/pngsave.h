@@ -0,0 +1,66 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PNGSAVE_H
+#define PNGSAVE_H
+
+#include <node.h>
+#include <QImage>
+#include <QString>
+#include <nan.h>
+#include "pngencoder.h"
+
+//
+// PngSave
+// Shared implementation of the options form of QImage/QPixmap save() and
+// saveAsync(), on top of PngEncoder
+//
+namespace PngSave {
+
+struct Options {
+  int compression;            // 0-9, default 6
+  PngEncoder::Filter filter;  // default FilterAdaptive
+  int threads;                // default QThread::idealThreadCount()
+};
+
+// Reads { compression, filter: 'none'|'sub'|'up'|'average'|'paeth'|
+// 'adaptive', threads } from a JS object. Missing keys keep defaults
+bool parseOptions(v8::Handle<v8::Value> value, Options* options,
+                  QString* error);
+
+bool save(const QImage& image, const QString& file, const Options& options,
+          QString* error);
+
+// Encodes on libuv's thread pool and calls callback(error)
+void saveAsync(const QImage& image, const QString& file,
+               const Options& options, v8::Local<v8::Function> callback);
+
+}
+
+#endif
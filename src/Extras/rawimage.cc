@@ -0,0 +1,230 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <climits>
+#include <cstring>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include "rawimage.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = { 'Q', 'T', 'R', 'A', 'W', 'I', 'M', 'G' };
+const quint32 kByteOrderMark = 0x01020304;
+
+struct Header {
+  char magic[8];
+  quint32 byteOrder;
+  quint32 version;
+  quint32 width;
+  quint32 height;
+  quint32 bytesPerLine;
+  quint32 format;
+  quint32 dataOffset;
+};
+
+// Tells a file apart from the one that replaced it at the same path
+struct FileId {
+  qint64 size;
+  qint64 modified;
+  quint64 device;
+  quint64 inode;
+
+  bool operator==(const FileId& other) const {
+    return size == other.size && modified == other.modified &&
+           device == other.device && inode == other.inode;
+  }
+  bool operator!=(const FileId& other) const { return !(*this == other); }
+};
+
+FileId identify(const QString& path) {
+  FileId id;
+#ifdef Q_OS_UNIX
+  struct stat st;
+  if (::stat(QFile::encodeName(path).constData(), &st) == 0) {
+    id.size = st.st_size;
+    id.modified = st.st_mtime;
+    id.device = st.st_dev;
+    id.inode = st.st_ino;
+    return id;
+  }
+#endif
+  QFileInfo info(path);
+  id.size = info.size();
+  id.modified = info.lastModified().toMSecsSinceEpoch();
+  id.device = 0;
+  id.inode = 0;
+  return id;
+}
+
+struct Mapping {
+  QFile* file;
+  FileId id;
+  QImage image;
+};
+
+// Keyed by canonical path, and mapped again when the file at that path is
+// replaced. Never unmapped: QImage (Qt 4) has no cleanup hook, so a
+// shallow copy handed out earlier could otherwise dangle
+QHash<QString, Mapping> mappings;
+QList<Mapping> replaced;
+
+bool fail(QString* error, const QString& message) {
+  if (error) *error = message;
+  return false;
+}
+
+}
+
+bool RawImage::save(const QImage& image, const QString& path,
+                    QString* error) {
+  if (image.isNull())
+    return fail(error, "RawImage: null image");
+
+  QString canonical = QFileInfo(path).canonicalFilePath();
+  if (!canonical.isEmpty() && mappings.contains(canonical))
+    return fail(error, "RawImage: " + path + " is mapped by this process");
+
+  QImage::Format format = image.format() == QImage::Format_RGB32 ?
+      QImage::Format_RGB32 : QImage::Format_ARGB32_Premultiplied;
+  QImage converted = image.convertToFormat(format);
+
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.byteOrder = kByteOrderMark;
+  header.version = Version;
+  header.width = converted.width();
+  header.height = converted.height();
+  header.bytesPerLine = converted.bytesPerLine();
+  header.format = format;
+  header.dataOffset = DataOffset;
+
+  char padding[DataOffset - sizeof(Header)];
+  memset(padding, 0, sizeof(padding));
+
+  // Write next to the target and rename over it, so other processes that
+  // have the old file mapped keep seeing intact pages
+  QString temp = path + ".tmp";
+  QFile file(temp);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return fail(error, "RawImage: " + file.errorString());
+
+  qint64 size = (qint64)header.bytesPerLine * header.height;
+  bool ok = file.write((const char*)&header, sizeof(header)) == sizeof(header)
+      && file.write(padding, sizeof(padding)) == (qint64)sizeof(padding)
+      && file.write((const char*)converted.constBits(), size) == size;
+  file.close();
+
+  if (!ok) {
+    QFile::remove(temp);
+    return fail(error, "RawImage: " + file.errorString());
+  }
+
+  QFile::remove(path);
+  if (!QFile::rename(temp, path)) {
+    QFile::remove(temp);
+    return fail(error, "RawImage: could not rename " + temp);
+  }
+
+  return true;
+}
+
+QImage RawImage::load(const QString& path, QString* error) {
+  QString canonical = QFileInfo(path).canonicalFilePath();
+  if (canonical.isEmpty()) {
+    fail(error, "RawImage: " + path + " does not exist");
+    return QImage();
+  }
+
+  FileId id = identify(canonical);
+  QHash<QString, Mapping>::iterator it = mappings.find(canonical);
+  if (it != mappings.end()) {
+    if (it.value().id == id)
+      return it.value().image;
+    replaced.append(it.value());
+    mappings.erase(it);
+  }
+
+  QFile* file = new QFile(canonical);
+  if (!file->open(QIODevice::ReadOnly)) {
+    fail(error, "RawImage: " + file->errorString());
+    delete file;
+    return QImage();
+  }
+
+  Header header;
+  bool valid = file->read((char*)&header, sizeof(header)) == sizeof(header)
+      && memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+      && header.byteOrder == kByteOrderMark
+      && header.version == Version
+      && (header.format == QImage::Format_RGB32 ||
+          header.format == QImage::Format_ARGB32 ||
+          header.format == QImage::Format_ARGB32_Premultiplied)
+      && header.width > 0 && header.height > 0
+      && header.width <= INT_MAX / 4 && header.height <= INT_MAX
+      && header.bytesPerLine <= INT_MAX
+      && header.bytesPerLine >= (quint64)header.width * 4
+      && header.bytesPerLine % 4 == 0
+      && header.dataOffset >= sizeof(header)
+      && header.dataOffset % 4 == 0
+      && header.dataOffset + (qint64)header.bytesPerLine * header.height
+          <= file->size();
+
+  if (!valid) {
+    fail(error, "RawImage: " + path + " is not a valid raw image");
+    delete file;
+    return QImage();
+  }
+
+  qint64 size = (qint64)header.bytesPerLine * header.height;
+  uchar* data = file->map(header.dataOffset, size);
+  if (!data) {
+    fail(error, "RawImage: " + file->errorString());
+    delete file;
+    return QImage();
+  }
+
+  // The const uchar* constructor keeps QImage from ever writing through
+  // the (read-only) mapping
+  Mapping mapping;
+  mapping.file = file;
+  mapping.id = id;
+  mapping.image = QImage((const uchar*)data, header.width, header.height,
+                         header.bytesPerLine, (QImage::Format)header.format);
+  mappings.insert(canonical, mapping);
+
+  return mapping.image;
+}
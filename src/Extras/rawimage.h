@@ -0,0 +1,69 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef RAWIMAGE_H
+#define RAWIMAGE_H
+
+#include <QImage>
+#include <QString>
+#include <QtGlobal>
+
+//
+// RawImage
+// Uncompressed container for 32-bit images: a fixed header followed by the
+// scanlines exactly as QImage lays them out in memory. load() maps the file
+// read-only and wraps the mapping in a QImage, so there is no decode and no
+// copy, and the pages are shared with every other process mapping the file
+//
+// Layout (native byte order):
+//   0   char[8]  "QTRAWIMG"
+//   8   quint32  byte order mark, 0x01020304
+//   12  quint32  version
+//   16  quint32  width
+//   20  quint32  height
+//   24  quint32  bytesPerLine
+//   28  quint32  QImage::Format
+//   32  quint32  dataOffset
+//   ..  padding up to dataOffset
+//
+namespace RawImage {
+
+enum { Version = 1, DataOffset = 64 };
+
+// Writes image as ARGB32_Premultiplied, or RGB32 if it is already opaque
+bool save(const QImage& image, const QString& path, QString* error);
+
+// Maps path and returns a read-only QImage over it. Mappings are cached per
+// path and live until exit, so the result (and any copy of it) never
+// dangles; writing to the image detaches it into a private heap copy
+QImage load(const QString& path, QString* error);
+
+}
+
+#endif
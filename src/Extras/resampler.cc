@@ -0,0 +1,275 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cmath>
+#include <QList>
+#include <QVector>
+#include <QtConcurrentMap>
+#include "resampler.h"
+
+namespace {
+
+const int kBandRows = 32;
+
+double filterSupport(Resampler::Filter filter) {
+  switch (filter) {
+    case Resampler::Box: return 0.5;
+    case Resampler::Bilinear: return 1.0;
+    case Resampler::Lanczos: return 3.0;
+  }
+  return 1.0;
+}
+
+double sinc(double x) {
+  if (x == 0.0)
+    return 1.0;
+  x *= M_PI;
+  return sin(x) / x;
+}
+
+double filterValue(Resampler::Filter filter, double x) {
+  x = fabs(x);
+  switch (filter) {
+    case Resampler::Box:
+      return x <= 0.5 ? 1.0 : 0.0;
+    case Resampler::Bilinear:
+      return x < 1.0 ? 1.0 - x : 0.0;
+    case Resampler::Lanczos:
+      return x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+  }
+  return 0.0;
+}
+
+//
+// Contributions
+// For every destination pixel along one axis, the run of source pixels
+// that contribute to it and their normalized weights
+//
+struct Contributions {
+  QVector<int> start;
+  QVector<int> count;
+  QVector<int> offset;
+  QVector<float> weights;
+};
+
+Contributions computeContributions(int source, int dest,
+                                   Resampler::Filter filter) {
+  Contributions c;
+  c.start.resize(dest);
+  c.count.resize(dest);
+  c.offset.resize(dest);
+
+  double scale = (double)dest / source;
+  // Widen the filter when shrinking so every source pixel is covered
+  double stretch = scale < 1.0 ? 1.0 / scale : 1.0;
+  double radius = filterSupport(filter) * stretch;
+
+  for (int i = 0; i < dest; ++i) {
+    double center = (i + 0.5) / scale;
+    int left = qMax(0, (int)floor(center - radius));
+    int right = qMin(source, (int)ceil(center + radius));
+
+    int first = c.weights.size();
+    double sum = 0.0;
+    for (int j = left; j < right; ++j) {
+      double w = filterValue(filter, (j + 0.5 - center) / stretch);
+      c.weights.append(w);
+      sum += w;
+    }
+
+    if (sum == 0.0) {
+      // Can only happen with Box at exact half-pixel offsets; fall back to
+      // the nearest source pixel
+      c.weights.resize(first);
+      left = qBound(0, (int)center, source - 1);
+      right = left + 1;
+      c.weights.append(1.0f);
+      sum = 1.0;
+    }
+
+    for (int k = first; k < c.weights.size(); ++k)
+      c.weights[k] /= sum;
+
+    c.start[i] = left;
+    c.count[i] = right - left;
+    c.offset[i] = first;
+  }
+
+  return c;
+}
+
+inline QRgb packPremultiplied(float a, float r, float g, float b) {
+  int ia = qBound(0, (int)(a + 0.5f), 255);
+  // Negative lobes (Lanczos) can overshoot; keep color <= alpha so the
+  // pixel stays a valid premultiplied value
+  int ir = qBound(0, (int)(r + 0.5f), ia);
+  int ig = qBound(0, (int)(g + 0.5f), ia);
+  int ib = qBound(0, (int)(b + 0.5f), ia);
+  return qRgba(ir, ig, ib, ia);
+}
+
+struct Band {
+  int first;
+  int last;
+};
+
+QList<Band> makeBands(int rows) {
+  QList<Band> bands;
+  for (int y = 0; y < rows; y += kBandRows) {
+    Band band = { y, qMin(rows, y + kBandRows) };
+    bands.append(band);
+  }
+  return bands;
+}
+
+//
+// HorizontalPass
+// Resizes the rows of a band along x
+//
+class HorizontalPass {
+ public:
+  typedef void result_type;
+
+  HorizontalPass(const uchar* source, int sourceStride, uchar* dest,
+                 int destStride, int width, const Contributions* c)
+      : source_(source), sourceStride_(sourceStride), dest_(dest),
+        destStride_(destStride), width_(width), c_(c) {}
+
+  void operator()(const Band& band) const {
+    for (int y = band.first; y < band.last; ++y) {
+      const QRgb* in = (const QRgb*)(source_ + y * sourceStride_);
+      QRgb* out = (QRgb*)(dest_ + y * destStride_);
+
+      for (int x = 0; x < width_; ++x) {
+        const QRgb* p = in + c_->start[x];
+        const float* w = c_->weights.constData() + c_->offset[x];
+        float a = 0, r = 0, g = 0, b = 0;
+        for (int k = 0; k < c_->count[x]; ++k) {
+          a += w[k] * qAlpha(p[k]);
+          r += w[k] * qRed(p[k]);
+          g += w[k] * qGreen(p[k]);
+          b += w[k] * qBlue(p[k]);
+        }
+        out[x] = packPremultiplied(a, r, g, b);
+      }
+    }
+  }
+
+ private:
+  const uchar* source_;
+  int sourceStride_;
+  uchar* dest_;
+  int destStride_;
+  int width_;
+  const Contributions* c_;
+};
+
+//
+// VerticalPass
+// Produces a band of destination rows, accumulating whole source rows at a
+// time so memory is walked sequentially
+//
+class VerticalPass {
+ public:
+  typedef void result_type;
+
+  VerticalPass(const uchar* source, int sourceStride, uchar* dest,
+               int destStride, int width, const Contributions* c)
+      : source_(source), sourceStride_(sourceStride), dest_(dest),
+        destStride_(destStride), width_(width), c_(c) {}
+
+  void operator()(const Band& band) const {
+    QVector<float> sum(width_ * 4);
+
+    for (int y = band.first; y < band.last; ++y) {
+      sum.fill(0.0f);
+      float* s = sum.data();
+      const float* w = c_->weights.constData() + c_->offset[y];
+
+      for (int k = 0; k < c_->count[y]; ++k) {
+        const QRgb* in =
+            (const QRgb*)(source_ + (c_->start[y] + k) * sourceStride_);
+        for (int x = 0; x < width_; ++x) {
+          s[x * 4] += w[k] * qAlpha(in[x]);
+          s[x * 4 + 1] += w[k] * qRed(in[x]);
+          s[x * 4 + 2] += w[k] * qGreen(in[x]);
+          s[x * 4 + 3] += w[k] * qBlue(in[x]);
+        }
+      }
+
+      QRgb* out = (QRgb*)(dest_ + y * destStride_);
+      for (int x = 0; x < width_; ++x)
+        out[x] = packPremultiplied(s[x * 4], s[x * 4 + 1], s[x * 4 + 2],
+                                   s[x * 4 + 3]);
+    }
+  }
+
+ private:
+  const uchar* source_;
+  int sourceStride_;
+  uchar* dest_;
+  int destStride_;
+  int width_;
+  const Contributions* c_;
+};
+
+}
+
+QImage Resampler::resample(const QImage& image, int width, int height,
+                           Filter filter) {
+  if (image.isNull() || width <= 0 || height <= 0)
+    return QImage();
+
+  QImage::Format format = image.format();
+  QImage source = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+  // Pixel pointers are taken here, on the calling thread: scanLine() and
+  // bits() detach, which must not race between bands
+  QImage horizontal(width, source.height(),
+                    QImage::Format_ARGB32_Premultiplied);
+  QImage result(width, height, QImage::Format_ARGB32_Premultiplied);
+  if (horizontal.isNull() || result.isNull())
+    return QImage();
+
+  Contributions cx = computeContributions(source.width(), width, filter);
+  QList<Band> rows = makeBands(source.height());
+  QtConcurrent::blockingMap(rows, HorizontalPass(
+      source.constBits(), source.bytesPerLine(), horizontal.bits(),
+      horizontal.bytesPerLine(), width, &cx));
+
+  Contributions cy = computeContributions(source.height(), height, filter);
+  QList<Band> bands = makeBands(height);
+  QtConcurrent::blockingMap(bands, VerticalPass(
+      horizontal.constBits(), horizontal.bytesPerLine(), result.bits(),
+      result.bytesPerLine(), width, &cy));
+
+  if (format == QImage::Format_RGB32 || format == QImage::Format_ARGB32)
+    return result.convertToFormat(format);
+  return result;
+}
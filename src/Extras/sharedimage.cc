@@ -0,0 +1,296 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <climits>
+#include <cstring>
+#include "../qt_v8.h"
+#include "../QtGui/qimage.h"
+#include "sharedimage.h"
+
+using namespace v8;
+
+Persistent<Function> SharedImage::constructor;
+
+static const char kMagic[8] = { 'Q', 'T', 'S', 'H', 'I', 'M', 'G', '1' };
+static const int kDataOffset = 64;
+
+struct SharedImage::Header {
+  char magic[8];
+  quint32 width;
+  quint32 height;
+  quint32 bytesPerLine;
+  quint32 format;
+  quint32 dataOffset;
+  // Bumped by publish(); readers compare it to see new frames
+  quint32 serial;
+};
+
+SharedImage::SharedImage(QSharedMemory* memory)
+    : memory_(memory), imagesOut_(false) {
+  const Header* h = header();
+  pixels_ = (uchar*)memory_->data() + h->dataOffset;
+  width_ = h->width;
+  height_ = h->height;
+  bytesPerLine_ = h->bytesPerLine;
+  format_ = (QImage::Format)h->format;
+}
+
+SharedImage::~SharedImage() {
+  // QImages over the segment may have been shallow-copied into pyramids,
+  // async workers or other wrappers, and Qt 4's QImage has no cleanup hook
+  // to tell when the last copy is gone. Unless scripts detach() it, the
+  // segment is then kept attached for good
+  if (!imagesOut_)
+    delete memory_;
+  NanDispose(image_);
+}
+
+SharedImage::Header* SharedImage::header() const {
+  return static_cast<Header*>(memory_->data());
+}
+
+void SharedImage::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("SharedImage"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("key"),
+      FunctionTemplate::New(Key)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("image"),
+      FunctionTemplate::New(Image)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("lock"),
+      FunctionTemplate::New(Lock)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("unlock"),
+      FunctionTemplate::New(Unlock)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("publish"),
+      FunctionTemplate::New(Publish)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("serial"),
+      FunctionTemplate::New(Serial)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("detach"),
+      FunctionTemplate::New(Detach)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("SharedImage"), tpl->GetFunction());
+}
+
+// Supported implementations:
+//   SharedImage ( QString key, int width, int height )
+//   SharedImage ( QString key, int width, int height, QImage::Format format )
+//     creates the segment (format defaults to ARGB32_Premultiplied)
+//   SharedImage ( QString key )
+//     attaches to a segment created by another SharedImage
+// The segment is destroyed when the last process detaches
+NAN_METHOD(SharedImage::New) {
+  NanScope();
+
+  if (!args[0]->IsString())
+    return NanThrowTypeError("SharedImage: bad arguments");
+
+  QSharedMemory* memory =
+      new QSharedMemory(qt_v8::ToQString(args[0]->ToString()));
+
+  if (args[1]->IsNumber() && args[2]->IsNumber()) {
+    qint64 width = args[1]->IntegerValue();
+    qint64 height = args[2]->IntegerValue();
+    QImage::Format format = args[3]->IsNumber() ?
+        (QImage::Format)args[3]->IntegerValue() :
+        QImage::Format_ARGB32_Premultiplied;
+
+    // QSharedMemory sizes are ints
+    if (width <= 0 || height <= 0 ||
+        width > INT_MAX / 4 || height > INT_MAX ||
+        width * 4 * height > INT_MAX - kDataOffset) {
+      delete memory;
+      return NanThrowRangeError("SharedImage: bad image size");
+    }
+    if (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32 &&
+        format != QImage::Format_ARGB32_Premultiplied) {
+      delete memory;
+      return NanThrowTypeError("SharedImage: format must be 32-bit");
+    }
+
+    int bytesPerLine = width * 4;
+    if (!memory->create(kDataOffset + bytesPerLine * (int)height)) {
+      QString error = "SharedImage: " + memory->errorString();
+      delete memory;
+      return NanThrowError(error.toUtf8().constData());
+    }
+
+    memory->lock();
+    memset(memory->data(), 0, memory->size());
+    Header* h = static_cast<Header*>(memory->data());
+    memcpy(h->magic, kMagic, sizeof(kMagic));
+    h->width = width;
+    h->height = height;
+    h->bytesPerLine = bytesPerLine;
+    h->format = format;
+    h->dataOffset = kDataOffset;
+    h->serial = 0;
+    memory->unlock();
+  } else {
+    if (!memory->attach()) {
+      QString error = "SharedImage: " + memory->errorString();
+      delete memory;
+      return NanThrowError(error.toUtf8().constData());
+    }
+
+    // The header comes from another process; don't let it point QImage
+    // outside the segment
+    const Header* h = static_cast<const Header*>(memory->constData());
+    if (memory->size() < kDataOffset ||
+        memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 ||
+        (h->format != QImage::Format_RGB32 &&
+         h->format != QImage::Format_ARGB32 &&
+         h->format != QImage::Format_ARGB32_Premultiplied) ||
+        h->width == 0 || h->height == 0 ||
+        h->width > INT_MAX / 4 || h->height > INT_MAX ||
+        h->bytesPerLine > INT_MAX ||
+        h->bytesPerLine < (qint64)h->width * 4 ||
+        h->bytesPerLine % 4 != 0 ||
+        h->dataOffset < sizeof(Header) || h->dataOffset % 4 != 0 ||
+        (qint64)h->dataOffset + (qint64)h->bytesPerLine * h->height >
+            memory->size()) {
+      delete memory;
+      return NanThrowError("SharedImage: segment is not a shared image");
+    }
+  }
+
+  SharedImage* w = new SharedImage(memory);
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+NAN_METHOD(SharedImage::Key) {
+  NanScope();
+
+  SharedImage* w = ObjectWrap::Unwrap<SharedImage>(args.This());
+  if (!w->memory_)
+    return NanThrowError("SharedImage::key: segment was detached");
+
+  NanReturnValue(qt_v8::FromQString(w->memory_->key()));
+}
+
+// QUIRK:
+// Returns a QImage over the shared pixels themselves: painting into it is
+// visible to every attached process. Use lock()/unlock() around access
+// that must not tear. Anything else that holds on to the image (e.g. an
+// ImagePyramid) will make painting detach to a private copy. Every call
+// returns the same QImage object
+NAN_METHOD(SharedImage::Image) {
+  NanScope();
+
+  SharedImage* w = ObjectWrap::Unwrap<SharedImage>(args.This());
+  if (!w->memory_)
+    return NanThrowError("SharedImage::image: segment was detached");
+
+  if (w->image_.IsEmpty()) {
+    Handle<Value> image = QImageWrap::NewInstance(QImage(w->pixels_,
+        w->width_, w->height_, w->bytesPerLine_, w->format_));
+    NanAssignPersistent(Object, w->image_, image->ToObject());
+    w->imagesOut_ = true;
+  }
+
+  NanReturnValue(NanPersistentToLocal(w->image_));
+}
+
+NAN_METHOD(SharedImage::Lock) {
+  NanScope();
+
+  SharedImage* w = ObjectWrap::Unwrap<SharedImage>(args.This());
+  if (!w->memory_)
+    return NanThrowError("SharedImage::lock: segment was detached");
+
+  NanReturnValue(Boolean::New(w->memory_->lock()));
+}
+
+NAN_METHOD(SharedImage::Unlock) {
+  NanScope();
+
+  SharedImage* w = ObjectWrap::Unwrap<SharedImage>(args.This());
+  if (!w->memory_)
+    return NanThrowError("SharedImage::unlock: segment was detached");
+
+  NanReturnValue(Boolean::New(w->memory_->unlock()));
+}
+
+// Marks a new frame as ready, returning the new serial
+NAN_METHOD(SharedImage::Publish) {
+  NanScope();
+
+  SharedImage* w = ObjectWrap::Unwrap<SharedImage>(args.This());
+  if (!w->memory_)
+    return NanThrowError("SharedImage::publish: segment was detached");
+
+  w->memory_->lock();
+  quint32 serial = ++w->header()->serial;
+  w->memory_->unlock();
+
+  NanReturnValue(Integer::NewFromUnsigned(serial));
+}
+
+NAN_METHOD(SharedImage::Serial) {
+  NanScope();
+
+  SharedImage* w = ObjectWrap::Unwrap<SharedImage>(args.This());
+  if (!w->memory_)
+    return NanThrowError("SharedImage::serial: segment was detached");
+
+  w->memory_->lock();
+  quint32 serial = w->header()->serial;
+  w->memory_->unlock();
+
+  NanReturnValue(Integer::NewFromUnsigned(serial));
+}
+
+// QUIRK:
+// Unmaps the segment; on Unix the last process to detach removes it. The
+// QImage from image() becomes a null image, and any copy of it kept
+// elsewhere (an ImagePyramid, a pending async scale or save) must be gone
+// beforehand. Other methods throw afterwards
+NAN_METHOD(SharedImage::Detach) {
+  NanScope();
+
+  SharedImage* w = ObjectWrap::Unwrap<SharedImage>(args.This());
+
+  if (!w->image_.IsEmpty()) {
+    node::ObjectWrap::Unwrap<QImageWrap>(NanPersistentToLocal(w->image_))
+        ->SetWrapped(QImage());
+    NanDispose(w->image_);
+  }
+
+  delete w->memory_;
+  w->memory_ = NULL;
+  w->pixels_ = NULL;
+  w->imagesOut_ = false;
+
+  NanReturnUndefined();
+}
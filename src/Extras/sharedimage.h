@@ -0,0 +1,83 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SHAREDIMAGE_H
+#define SHAREDIMAGE_H
+
+#include <node.h>
+#include <QImage>
+#include <QSharedMemory>
+#include <nan.h>
+
+//
+// SharedImage
+// A 32-bit image whose pixels live in a QSharedMemory segment, so that
+// another process can attach to it by key and draw from (or into) the same
+// memory without copies or re-encoding. The segment starts with a small
+// header (size, stride, format and a publish serial) followed by the
+// scanlines. Once image() has been called, only detach() unmaps the
+// segment, as copies of that image may outlive the SharedImage; on Unix a
+// segment that is never detached outlives the process. Not a Qt class
+//
+class SharedImage : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+
+ private:
+  SharedImage(QSharedMemory* memory);
+  ~SharedImage();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(Key);
+  static NAN_METHOD(Image);
+  static NAN_METHOD(Lock);
+  static NAN_METHOD(Unlock);
+  static NAN_METHOD(Publish);
+  static NAN_METHOD(Serial);
+  static NAN_METHOD(Detach);
+
+  struct Header;
+  Header* header() const;
+
+  QSharedMemory* memory_;    // NULL once detached
+  bool imagesOut_;
+  v8::Persistent<v8::Object> image_;
+
+  // Geometry as validated when the segment was created or attached;
+  // the header itself may be rewritten by other processes
+  uchar* pixels_;
+  int width_;
+  int height_;
+  int bytesPerLine_;
+  QImage::Format format_;
+};
+
+#endif
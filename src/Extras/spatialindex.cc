@@ -0,0 +1,493 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <climits>
+#include <node.h>
+#include <qmath.h>
+#include <qnumeric.h>
+#include "../qt_v8.h"
+#include "../QtGui/qpainterpath.h"
+#include "spatialindex.h"
+
+using namespace v8;
+
+// Shapes covering more cells than this go to the oversize list
+static const int kMaxCells = 256;
+
+// Cell coordinates are clamped to this, so far away shapes share the edge
+// cells and QRect::width()/height() of a cell span can't overflow
+static const int kMaxCell = INT_MAX / 2 - 1;
+
+Persistent<Function> SpatialIndex::constructor;
+
+SpatialIndex::SpatialIndex(qreal cellSize)
+    : cellSize_(cellSize), nextOrder_(0), queryMark_(0) {
+}
+
+SpatialIndex::~SpatialIndex() {
+}
+
+void SpatialIndex::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("SpatialIndex"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("insert"),
+      FunctionTemplate::New(Insert)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("update"),
+      FunctionTemplate::New(Update)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("remove"),
+      FunctionTemplate::New(Remove)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("contains"),
+      FunctionTemplate::New(Contains)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("count"),
+      FunctionTemplate::New(Count)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("clear"),
+      FunctionTemplate::New(Clear)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("at"),
+      FunctionTemplate::New(At)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("topAt"),
+      FunctionTemplate::New(TopAt)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("query"),
+      FunctionTemplate::New(Query)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("SpatialIndex"), tpl->GetFunction());
+}
+
+// Supported implementations:
+//   SpatialIndex ( )
+//   SpatialIndex ( Number cellSize )
+// Cells default to 64x64; roughly the size of a typical shape works best
+NAN_METHOD(SpatialIndex::New) {
+  NanScope();
+
+  qreal cellSize = 64;
+  if (args.Length() > 0) {
+    if (!args[0]->IsNumber() || !(args[0]->NumberValue() > 0) ||
+        !qIsFinite(args[0]->NumberValue()))
+      return NanThrowTypeError("SpatialIndex::SpatialIndex: bad arguments");
+    cellSize = args[0]->NumberValue();
+  }
+
+  SpatialIndex* w = new SpatialIndex(cellSize);
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+// Cell holding coordinate v; v must be finite
+static int CellOf(qreal v, qreal cellSize) {
+  qreal c = ::floor(v / cellSize);
+  return int(qBound(qreal(-kMaxCell), c, qreal(kMaxCell)));
+}
+
+static qint64 CellCount(const QRect& cells) {
+  return (qint64(cells.right()) - cells.left() + 1) *
+         (qint64(cells.bottom()) - cells.top() + 1);
+}
+
+QRect SpatialIndex::cellsFor(const QRectF& rect) const {
+  return QRect(QPoint(CellOf(rect.left(), cellSize_),
+                      CellOf(rect.top(), cellSize_)),
+               QPoint(CellOf(rect.right(), cellSize_),
+                      CellOf(rect.bottom(), cellSize_)));
+}
+
+QVector<int>* SpatialIndex::cell(int cx, int cy, bool create) {
+  quint64 key = (quint64(quint32(cx)) << 32) | quint32(cy);
+  if (create)
+    return &grid_[key];
+
+  QHash<quint64, QVector<int> >::iterator it = grid_.find(key);
+  return it == grid_.end() ? NULL : &it.value();
+}
+
+// Links entries_[slot] into the grid
+void SpatialIndex::add(int slot) {
+  Entry& e = entries_[slot];
+  e.cells = cellsFor(e.bounds);
+  e.oversize = CellCount(e.cells) > kMaxCells;
+
+  if (e.oversize) {
+    oversize_.append(slot);
+    return;
+  }
+
+  for (int cy = e.cells.top(); cy <= e.cells.bottom(); ++cy)
+    for (int cx = e.cells.left(); cx <= e.cells.right(); ++cx)
+      cell(cx, cy, true)->append(slot);
+}
+
+// Unlinks entries_[slot] from the grid
+void SpatialIndex::drop(int slot) {
+  Entry& e = entries_[slot];
+
+  if (e.oversize) {
+    oversize_.remove(oversize_.indexOf(slot));
+    return;
+  }
+
+  for (int cy = e.cells.top(); cy <= e.cells.bottom(); ++cy) {
+    for (int cx = e.cells.left(); cx <= e.cells.right(); ++cx) {
+      QVector<int>* bucket = cell(cx, cy, false);
+      int i = bucket->indexOf(slot);
+      (*bucket)[i] = bucket->last();
+      bucket->pop_back();
+      if (bucket->isEmpty())
+        grid_.remove((quint64(quint32(cx)) << 32) | quint32(cy));
+    }
+  }
+}
+
+bool SpatialIndex::hit(const Entry& e, const QPointF& p) const {
+  if (!e.bounds.contains(p))
+    return false;
+  return !e.isPath || e.path.contains(p);
+}
+
+bool SpatialIndex::hit(const Entry& e, const QRectF& r) const {
+  if (!e.bounds.intersects(r))
+    return false;
+  return !e.isPath || e.path.intersects(r);
+}
+
+static bool IsFinite(const QRectF& r) {
+  return qIsFinite(r.left()) && qIsFinite(r.top()) &&
+         qIsFinite(r.right()) && qIsFinite(r.bottom());
+}
+
+// Reads count finite numbers starting at args[first]
+static bool ReadNumbers(_NAN_METHOD_ARGS, int first, int count, qreal* out) {
+  if (args.Length() < first + count)
+    return false;
+  for (int i = 0; i < count; ++i) {
+    if (!args[first + i]->IsNumber())
+      return false;
+    out[i] = args[first + i]->NumberValue();
+    if (!qIsFinite(out[i]))
+      return false;
+  }
+  return true;
+}
+
+// Reads a finite rect (Number x, Number y, Number w, Number h) starting at
+// args[first]
+static bool ReadRect(_NAN_METHOD_ARGS, int first, QRectF* rect) {
+  qreal v[4];
+  if (!ReadNumbers(args, first, 4, v))
+    return false;
+  *rect = QRectF(v[0], v[1], v[2], v[3]).normalized();
+  return IsFinite(*rect);
+}
+
+// Reads a shape starting at args[first]:
+//   (QPainterPath path)
+//   (Number x, Number y, Number w, Number h)
+static bool ReadShape(_NAN_METHOD_ARGS, int first, QRectF* bounds,
+                      QPainterPath* path, bool* isPath) {
+  if (args[first]->IsObject() &&
+      qt_v8::ToQString(args[first]->ToObject()->GetConstructorName()) ==
+      "QPainterPath") {
+    *path = *node::ObjectWrap::Unwrap<QPainterPathWrap>(
+        args[first]->ToObject())->GetWrapped();
+    *bounds = path->boundingRect();
+    *isPath = true;
+    return IsFinite(*bounds);
+  }
+
+  if (!ReadRect(args, first, bounds))
+    return false;
+  *path = QPainterPath();
+  *isPath = false;
+  return true;
+}
+
+// Supported versions:
+//   insert(Number id, QPainterPath path)
+//   insert(Number id, Number x, Number y, Number w, Number h)
+NAN_METHOD(SpatialIndex::Insert) {
+  NanScope();
+
+  SpatialIndex* w = ObjectWrap::Unwrap<SpatialIndex>(args.This());
+
+  Entry e;
+  if (!args[0]->IsNumber() ||
+      !ReadShape(args, 1, &e.bounds, &e.path, &e.isPath))
+    return NanThrowTypeError("SpatialIndex::insert: bad arguments");
+
+  e.id = args[0]->Uint32Value();
+  if (w->slots_.contains(e.id))
+    return NanThrowError("SpatialIndex::insert: id is already in the index");
+
+  e.order = w->nextOrder_++;
+  e.mark = 0;
+
+  int slot;
+  if (w->free_.isEmpty()) {
+    slot = w->entries_.size();
+    w->entries_.append(e);
+  } else {
+    slot = w->free_.last();
+    w->free_.pop_back();
+    w->entries_[slot] = e;
+  }
+
+  w->slots_.insert(e.id, slot);
+  w->add(slot);
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   update(Number id, QPainterPath path)
+//   update(Number id, Number x, Number y, Number w, Number h)
+// The shape keeps its stacking order
+NAN_METHOD(SpatialIndex::Update) {
+  NanScope();
+
+  SpatialIndex* w = ObjectWrap::Unwrap<SpatialIndex>(args.This());
+
+  QRectF bounds;
+  QPainterPath path;
+  bool isPath;
+  if (!args[0]->IsNumber() || !ReadShape(args, 1, &bounds, &path, &isPath))
+    return NanThrowTypeError("SpatialIndex::update: bad arguments");
+
+  QHash<quint32, int>::const_iterator it =
+      w->slots_.constFind(args[0]->Uint32Value());
+  if (it == w->slots_.constEnd())
+    return NanThrowRangeError("SpatialIndex::update: no such id");
+
+  int slot = it.value();
+  Entry& e = w->entries_[slot];
+
+  // Moves within the same cells skip the grid entirely
+  bool relink = e.oversize || w->cellsFor(bounds) != e.cells;
+  if (relink)
+    w->drop(slot);
+
+  e.bounds = bounds;
+  e.path = path;
+  e.isPath = isPath;
+
+  if (relink)
+    w->add(slot);
+
+  NanReturnUndefined();
+}
+
+// Returns false if the id was not in the index
+NAN_METHOD(SpatialIndex::Remove) {
+  NanScope();
+
+  SpatialIndex* w = ObjectWrap::Unwrap<SpatialIndex>(args.This());
+
+  QHash<quint32, int>::iterator it = w->slots_.find(args[0]->Uint32Value());
+  if (it == w->slots_.end())
+    NanReturnValue(False());
+
+  int slot = it.value();
+  w->slots_.erase(it);
+  w->drop(slot);
+  w->entries_[slot].path = QPainterPath();
+  w->free_.append(slot);
+
+  NanReturnValue(True());
+}
+
+NAN_METHOD(SpatialIndex::Contains) {
+  NanScope();
+
+  SpatialIndex* w = ObjectWrap::Unwrap<SpatialIndex>(args.This());
+
+  NanReturnValue(Boolean::New(w->slots_.contains(args[0]->Uint32Value())));
+}
+
+NAN_METHOD(SpatialIndex::Count) {
+  NanScope();
+
+  SpatialIndex* w = ObjectWrap::Unwrap<SpatialIndex>(args.This());
+
+  NanReturnValue(Integer::New(w->slots_.size()));
+}
+
+NAN_METHOD(SpatialIndex::Clear) {
+  NanScope();
+
+  SpatialIndex* w = ObjectWrap::Unwrap<SpatialIndex>(args.This());
+
+  w->entries_.clear();
+  w->free_.clear();
+  w->slots_.clear();
+  w->grid_.clear();
+  w->oversize_.clear();
+
+  NanReturnUndefined();
+}
+
+// Sorts hits topmost (most recently inserted) first
+static bool TopmostFirst(const QPair<quint32, quint32>& a,
+                         const QPair<quint32, quint32>& b) {
+  return a.first > b.first;
+}
+
+static Handle<Array> HitArray(QVector<QPair<quint32, quint32> >& hits) {
+  NanScope();
+
+  qSort(hits.begin(), hits.end(), TopmostFirst);
+
+  Local<Array> array = Array::New(hits.size());
+  for (int i = 0; i < hits.size(); ++i)
+    array->Set(i, Integer::NewFromUnsigned(hits[i].second));
+
+  return scope.Close(array);
+}
+
+// Ids of the shapes containing (x, y), topmost first
+NAN_METHOD(SpatialIndex::At) {
+  NanScope();
+
+  SpatialIndex* w = ObjectWrap::Unwrap<SpatialIndex>(args.This());
+
+  qreal xy[2];
+  if (!ReadNumbers(args, 0, 2, xy))
+    return NanThrowTypeError("SpatialIndex::at: bad arguments");
+
+  QPointF p(xy[0], xy[1]);
+  QVector<QPair<quint32, quint32> > hits;
+
+  QVector<int>* bucket = w->cell(CellOf(p.x(), w->cellSize_),
+                                CellOf(p.y(), w->cellSize_), false);
+  for (int pass = 0; pass < 2; ++pass) {
+    const QVector<int>* list = pass ? &w->oversize_ : bucket;
+    if (!list)
+      continue;
+    for (int i = 0; i < list->size(); ++i) {
+      const Entry& e = w->entries_[list->at(i)];
+      if (w->hit(e, p))
+        hits.append(qMakePair(e.order, e.id));
+    }
+  }
+
+  NanReturnValue(HitArray(hits));
+}
+
+// Id of the topmost shape containing (x, y), or null. Allocates nothing,
+// for per-mouse-move hover tests
+NAN_METHOD(SpatialIndex::TopAt) {
+  NanScope();
+
+  SpatialIndex* w = ObjectWrap::Unwrap<SpatialIndex>(args.This());
+
+  qreal xy[2];
+  if (!ReadNumbers(args, 0, 2, xy))
+    return NanThrowTypeError("SpatialIndex::topAt: bad arguments");
+
+  QPointF p(xy[0], xy[1]);
+  const Entry* top = NULL;
+
+  QVector<int>* bucket = w->cell(CellOf(p.x(), w->cellSize_),
+                                CellOf(p.y(), w->cellSize_), false);
+  for (int pass = 0; pass < 2; ++pass) {
+    const QVector<int>* list = pass ? &w->oversize_ : bucket;
+    if (!list)
+      continue;
+    for (int i = 0; i < list->size(); ++i) {
+      const Entry& e = w->entries_[list->at(i)];
+      if ((!top || e.order > top->order) && w->hit(e, p))
+        top = &e;
+    }
+  }
+
+  if (!top)
+    NanReturnNull();
+
+  NanReturnValue(Integer::NewFromUnsigned(top->id));
+}
+
+// Ids of the shapes intersecting the rect (x, y, w, h), topmost first
+NAN_METHOD(SpatialIndex::Query) {
+  NanScope();
+
+  SpatialIndex* w = ObjectWrap::Unwrap<SpatialIndex>(args.This());
+
+  QRectF rect;
+  if (!ReadRect(args, 0, &rect))
+    return NanThrowTypeError("SpatialIndex::query: bad arguments");
+
+  QRect cells = w->cellsFor(rect);
+  QVector<QPair<quint32, quint32> > hits;
+
+  // Shapes spanning several cells must only be reported once
+  quint32 mark = ++w->queryMark_;
+
+  // Huge rects visit the occupied cells rather than every covered one
+  bool scanGrid = CellCount(cells) > w->grid_.size();
+
+  QHash<quint64, QVector<int> >::iterator it = w->grid_.begin();
+  for (int cy = cells.top(), cx = cells.left(); ; ) {
+    const QVector<int>* list;
+    if (scanGrid) {
+      if (it == w->grid_.end())
+        break;
+      list = &it.value();
+      ++it;
+    } else {
+      if (cy > cells.bottom())
+        break;
+      list = w->cell(cx, cy, false);
+      if (++cx > cells.right()) {
+        cx = cells.left();
+        ++cy;
+      }
+      if (!list)
+        continue;
+    }
+
+    for (int i = 0; i < list->size(); ++i) {
+      Entry& e = w->entries_[list->at(i)];
+      if (e.mark == mark)
+        continue;
+      e.mark = mark;
+      if (w->hit(e, rect))
+        hits.append(qMakePair(e.order, e.id));
+    }
+  }
+
+  for (int i = 0; i < w->oversize_.size(); ++i) {
+    const Entry& e = w->entries_[w->oversize_[i]];
+    if (w->hit(e, rect))
+      hits.append(qMakePair(e.order, e.id));
+  }
+
+  NanReturnValue(HitArray(hits));
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <node.h>
+#include <QHash>
+#include <QPainterPath>
+#include <QRect>
+#include <QVector>
+#include <nan.h>
+
+//
+// SpatialIndex
+// Uniform grid of shapes (rects or QPainterPaths) keyed by integer ids, for
+// hit testing things painted by hand with QPainter. Queries look only at
+// the cells they touch, then refine candidates against the exact shape
+// with QPainterPath::contains() / intersects(). Shapes spanning too many
+// cells are kept in a separate list that every query scans. Not a Qt class
+//
+class SpatialIndex : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+
+ private:
+  SpatialIndex(qreal cellSize);
+  ~SpatialIndex();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(Insert);
+  static NAN_METHOD(Update);
+  static NAN_METHOD(Remove);
+  static NAN_METHOD(Contains);
+  static NAN_METHOD(Count);
+  static NAN_METHOD(Clear);
+  static NAN_METHOD(At);
+  static NAN_METHOD(TopAt);
+  static NAN_METHOD(Query);
+
+  struct Entry {
+    quint32 id;
+    quint32 order;      // insertion order; later shapes are on top
+    quint32 mark;       // last query that visited this entry
+    bool isPath;
+    bool oversize;
+    QRectF bounds;
+    QRect cells;        // grid cells covered, unused if oversize
+    QPainterPath path;
+  };
+
+  void add(int slot);
+  void drop(int slot);
+  QRect cellsFor(const QRectF& rect) const;
+  bool hit(const Entry& e, const QPointF& p) const;
+  bool hit(const Entry& e, const QRectF& r) const;
+  QVector<int>* cell(int cx, int cy, bool create);
+
+  qreal cellSize_;
+  quint32 nextOrder_;
+  quint32 queryMark_;
+
+  QVector<Entry> entries_;
+  QVector<int> free_;                       // reusable slots in entries_
+  QHash<quint32, int> slots_;               // id -> slot
+  QHash<quint64, QVector<int> > grid_;      // cell -> slots
+  QVector<int> oversize_;
+};
+
+#endif
@@ -29,6 +29,7 @@
 
 #include <node.h>
 #include "qpointf.h"
+#include "../qt_v8.h"
 
 using namespace v8;
 
@@ -49,6 +50,9 @@ QPointFWrap::~QPointFWrap() {
 }
 
 void QPointFWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QPointF"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("QPointF"));
@@ -78,6 +82,8 @@ NAN_METHOD(QPointFWrap::New) {
 Handle<Value> QPointFWrap::NewInstance(QPointF q) {
   NanScope();
 
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
   Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
   QPointFWrap* w = node::ObjectWrap::Unwrap<QPointFWrap>(instance);
   w->SetWrapped(q);
@@ -29,6 +29,7 @@
 
 #include <node.h>
 #include "qsize.h"
+#include "../qt_v8.h"
 
 using namespace v8;
 
@@ -44,6 +45,9 @@ QSizeWrap::~QSizeWrap() {
 }
 
 void QSizeWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QSize"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("QSize"));
@@ -71,6 +75,8 @@ NAN_METHOD(QSizeWrap::New) {
 Handle<Value> QSizeWrap::NewInstance(QSize q) {
   NanScope();
 
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
   Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
   QSizeWrap* w = node::ObjectWrap::Unwrap<QSizeWrap>(instance);
   w->SetWrapped(q);
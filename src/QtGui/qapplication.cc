@@ -29,6 +29,7 @@
 
 #include <node.h>
 #include "qapplication.h"
+#include "qwidget.h"
 
 using namespace v8;
 
@@ -37,8 +38,19 @@ Persistent<Function> QApplicationWrap::constructor;
 int QApplicationWrap::argc_ = 0;
 char** QApplicationWrap::argv_ = NULL;
 
-QApplicationWrap::QApplicationWrap() {
-  q_ = new QApplication(argc_, argv_);
+// Supported implementations:
+//   QApplication ( )
+//   QApplication ( { gui: false } )
+//
+// Without gui the application doesn't connect to a display or load the
+// windowing stack, and painting uses the raster engine only. QImage,
+// QPainter on QImage, fonts, encoding and timers keep working; widgets and
+// pixmaps can't be created.
+QApplicationWrap::QApplicationWrap(bool gui) {
+  if (!gui)
+    QApplication::setGraphicsSystem("raster");
+
+  q_ = new QApplication(argc_, argv_, gui);
 }
 
 QApplicationWrap::~QApplicationWrap() {
@@ -56,6 +68,8 @@ void QApplicationWrap::Initialize(Handle<Object> target) {
       FunctionTemplate::New(ProcessEvents)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("exec"),
       FunctionTemplate::New(Exec)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("isGui"),
+      FunctionTemplate::New(IsGui)->GetFunction());
 
   NanAssignPersistent(Function, constructor, tpl->GetFunction());
   target->Set(String::NewSymbol("QApplication"), tpl->GetFunction());
@@ -64,7 +78,16 @@ void QApplicationWrap::Initialize(Handle<Object> target) {
 NAN_METHOD(QApplicationWrap::New) {
   NanScope();
 
-  QApplicationWrap* w = new QApplicationWrap();
+  bool gui = true;
+  if (args[0]->IsObject()) {
+    Local<Value> option = args[0]->ToObject()->Get(String::NewSymbol("gui"));
+    if (!option->IsUndefined())
+      gui = option->BooleanValue();
+  } else if (!args[0]->IsUndefined()) {
+    return NanThrowTypeError("QApplication::QApplication: bad arguments");
+  }
+
+  QApplicationWrap* w = new QApplicationWrap(gui);
   w->Wrap(args.This());
 
   NanReturnValue(args.This());
@@ -77,6 +100,7 @@ NAN_METHOD(QApplicationWrap::ProcessEvents) {
   QApplication* q = w->GetWrapped();
 
   q->processEvents();
+  QWidgetImpl::flushAllInput();
 
   NanReturnUndefined();
 }
@@ -91,3 +115,9 @@ NAN_METHOD(QApplicationWrap::Exec) {
 
   NanReturnUndefined();
 }
+
+NAN_METHOD(QApplicationWrap::IsGui) {
+  NanScope();
+
+  NanReturnValue(Boolean::New(HasGui()));
+}
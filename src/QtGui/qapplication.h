@@ -39,8 +39,11 @@ class QApplicationWrap : public node::ObjectWrap {
   static void Initialize(v8::Handle<v8::Object> target);
   QApplication* GetWrapped() const { return q_; };
 
+  // False when the application was created with { gui: false }
+  static bool HasGui() { return QApplication::type() != QApplication::Tty; }
+
  private:
-  QApplicationWrap();
+  QApplicationWrap(bool gui);
   ~QApplicationWrap();
   static v8::Persistent<v8::Function> constructor;
   static NAN_METHOD(New);
@@ -48,6 +51,7 @@ class QApplicationWrap : public node::ObjectWrap {
   // Wrapped methods
   static NAN_METHOD(ProcessEvents);
   static NAN_METHOD(Exec);
+  static NAN_METHOD(IsGui);
 
   // Wrapped object
   QApplication* q_;
@@ -99,6 +99,9 @@ QFontWrap::~QFontWrap() {
 }
 
 void QFontWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QFont"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("QFont"));
@@ -138,6 +141,8 @@ NAN_METHOD(QFontWrap::New) {
 Handle<Value> QFontWrap::NewInstance(QFont q) {
   NanScope();
 
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
   Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
   QFontWrap* w = node::ObjectWrap::Unwrap<QFontWrap>(instance);
   w->SetWrapped(q);
@@ -0,0 +1,582 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <node.h>
+#include "../qt_v8.h"
+#include "qgraphicsitem.h"
+#include "qpen.h"
+#include "qbrush.h"
+#include "../Extras/itemanimator.h"
+
+using namespace v8;
+
+Persistent<Function> QGraphicsItemWrap::constructor;
+bool QGraphicsItemWrap::cacheUsed = false;
+
+QGraphicsItemWrap::QGraphicsItemWrap() : q_(NULL) {
+  // Standalone constructor not implemented
+  // Use QGraphicsScene's addXxx() methods
+}
+
+QGraphicsItemWrap::~QGraphicsItemWrap() {
+}
+
+void QGraphicsItemWrap::SetWrapped(QGraphicsItem* q) {
+  if (!q && q_)
+    ItemAnimator::instance()->stop(q_, -1);
+  q_ = q;
+}
+
+void QGraphicsItemWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QGraphicsItem"))
+    return;
+
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("QGraphicsItem"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("type"),
+      FunctionTemplate::New(Type)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setPos"),
+      FunctionTemplate::New(SetPos)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("x"),
+      FunctionTemplate::New(X)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("y"),
+      FunctionTemplate::New(Y)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setZValue"),
+      FunctionTemplate::New(SetZValue)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("zValue"),
+      FunctionTemplate::New(ZValue)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setRotation"),
+      FunctionTemplate::New(SetRotation)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("rotation"),
+      FunctionTemplate::New(Rotation)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setScale"),
+      FunctionTemplate::New(SetScale)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("scale"),
+      FunctionTemplate::New(Scale)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setOpacity"),
+      FunctionTemplate::New(SetOpacity)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("opacity"),
+      FunctionTemplate::New(Opacity)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setVisible"),
+      FunctionTemplate::New(SetVisible)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("isVisible"),
+      FunctionTemplate::New(IsVisible)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setPen"),
+      FunctionTemplate::New(SetPen)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setBrush"),
+      FunctionTemplate::New(SetBrush)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setCacheMode"),
+      FunctionTemplate::New(SetCacheMode)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("cacheMode"),
+      FunctionTemplate::New(CacheMode)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("cacheStats"),
+      FunctionTemplate::New(CacheStats)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("resetCacheStats"),
+      FunctionTemplate::New(ResetCacheStats)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("animate"),
+      FunctionTemplate::New(Animate)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("stopAnimations"),
+      FunctionTemplate::New(StopAnimations)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("isAnimating"),
+      FunctionTemplate::New(IsAnimating)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("QGraphicsItem"), tpl->GetFunction());
+}
+
+NAN_METHOD(QGraphicsItemWrap::New) {
+  NanScope();
+
+  QGraphicsItemWrap* w = new QGraphicsItemWrap();
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+Handle<Object> QGraphicsItemWrap::NewInstance(QGraphicsItem* q) {
+  NanScope();
+
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
+  Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(instance);
+  w->SetWrapped(q);
+
+  return scope.Close(instance);
+}
+
+// Addons are built without RTTI, so the item class is told by type()
+QGraphicsItemStats* QGraphicsItemWrap::Stats(QGraphicsItem* q) {
+  switch (q->type()) {
+    case QGraphicsRectItem::Type:
+      return static_cast<QGraphicsItemImpl<QGraphicsRectItem>*>(q);
+    case QGraphicsPathItem::Type:
+      return static_cast<QGraphicsItemImpl<QGraphicsPathItem>*>(q);
+    case QGraphicsPixmapItem::Type:
+      return static_cast<QGraphicsItemImpl<QGraphicsPixmapItem>*>(q);
+    case QGraphicsSimpleTextItem::Type:
+      return static_cast<QGraphicsItemImpl<QGraphicsSimpleTextItem>*>(q);
+    default:
+      return NULL;
+  }
+}
+
+// QGraphicsItem::type(): 2 path, 3 rect, 7 pixmap, 9 simple text
+NAN_METHOD(QGraphicsItemWrap::Type) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::type: item was removed");
+
+  NanReturnValue(Integer::New(q->type()));
+}
+
+NAN_METHOD(QGraphicsItemWrap::SetPos) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::setPos: item was removed");
+
+  q->setPos(args[0]->NumberValue(), args[1]->NumberValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsItemWrap::X) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::x: item was removed");
+
+  NanReturnValue(Number::New(q->x()));
+}
+
+NAN_METHOD(QGraphicsItemWrap::Y) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::y: item was removed");
+
+  NanReturnValue(Number::New(q->y()));
+}
+
+NAN_METHOD(QGraphicsItemWrap::SetZValue) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::setZValue: item was removed");
+
+  q->setZValue(args[0]->NumberValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsItemWrap::ZValue) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::zValue: item was removed");
+
+  NanReturnValue(Number::New(q->zValue()));
+}
+
+NAN_METHOD(QGraphicsItemWrap::SetRotation) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::setRotation: item was removed");
+
+  q->setRotation(args[0]->NumberValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsItemWrap::Rotation) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::rotation: item was removed");
+
+  NanReturnValue(Number::New(q->rotation()));
+}
+
+NAN_METHOD(QGraphicsItemWrap::SetScale) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::setScale: item was removed");
+
+  q->setScale(args[0]->NumberValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsItemWrap::Scale) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::scale: item was removed");
+
+  NanReturnValue(Number::New(q->scale()));
+}
+
+NAN_METHOD(QGraphicsItemWrap::SetOpacity) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::setOpacity: item was removed");
+
+  q->setOpacity(args[0]->NumberValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsItemWrap::Opacity) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::opacity: item was removed");
+
+  NanReturnValue(Number::New(q->opacity()));
+}
+
+NAN_METHOD(QGraphicsItemWrap::SetVisible) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::setVisible: item was removed");
+
+  q->setVisible(args[0]->BooleanValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsItemWrap::IsVisible) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::isVisible: item was removed");
+
+  NanReturnValue(Boolean::New(q->isVisible()));
+}
+
+// Addons are built without RTTI, so no dynamic_cast
+static QAbstractGraphicsShapeItem* ShapeItem(QGraphicsItem* q) {
+  if (q && (q->type() == QGraphicsRectItem::Type ||
+            q->type() == QGraphicsPathItem::Type ||
+            q->type() == QGraphicsSimpleTextItem::Type))
+    return static_cast<QAbstractGraphicsShapeItem*>(q);
+  return NULL;
+}
+
+// Rect, path and simple text items only
+NAN_METHOD(QGraphicsItemWrap::SetPen) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QAbstractGraphicsShapeItem* q = ShapeItem(w->GetWrapped());
+
+  if (!q || !args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QPen")
+    return NanThrowTypeError("QGraphicsItem::setPen: bad arguments");
+
+  q->setPen(*ObjectWrap::Unwrap<QPenWrap>(args[0]->ToObject())->GetWrapped());
+
+  NanReturnUndefined();
+}
+
+// Rect, path and simple text items only
+NAN_METHOD(QGraphicsItemWrap::SetBrush) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QAbstractGraphicsShapeItem* q = ShapeItem(w->GetWrapped());
+
+  if (!q || !args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QBrush")
+    return NanThrowTypeError("QGraphicsItem::setBrush: bad arguments");
+
+  q->setBrush(*ObjectWrap::Unwrap<QBrushWrap>(args[0]->ToObject())->GetWrapped());
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   setCacheMode(CacheMode mode)
+//   setCacheMode(CacheMode mode, Number width, Number height)
+// Cached pixmaps are stored in QPixmapCache, whose limit bounds the
+// memory used by all cached items together
+NAN_METHOD(QGraphicsItemWrap::SetCacheMode) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::setCacheMode: item was removed");
+
+  int mode = args[0]->Int32Value();
+  if (mode < QGraphicsItem::NoCache || mode > QGraphicsItem::DeviceCoordinateCache)
+    return NanThrowRangeError("QGraphicsItem::setCacheMode: unknown mode");
+
+  QSize size;
+  if (args.Length() >= 3)
+    size = QSize(args[1]->Int32Value(), args[2]->Int32Value());
+
+  q->setCacheMode(static_cast<QGraphicsItem::CacheMode>(mode), size);
+  if (mode != QGraphicsItem::NoCache)
+    cacheUsed = true;
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsItemWrap::CacheMode) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::cacheMode: item was removed");
+
+  NanReturnValue(Integer::New(q->cacheMode()));
+}
+
+// Returns { paints, draws, misses, hits }. Only view repaints are
+// counted as draws; hits are the draws served from the cache
+NAN_METHOD(QGraphicsItemWrap::CacheStats) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::cacheStats: item was removed");
+
+  QGraphicsItemStats* stats = Stats(q);
+
+  Local<Object> result = Object::New();
+  result->Set(String::NewSymbol("paints"),
+      Integer::NewFromUnsigned(stats->paints));
+  result->Set(String::NewSymbol("draws"),
+      Integer::NewFromUnsigned(stats->draws));
+  result->Set(String::NewSymbol("misses"),
+      Integer::NewFromUnsigned(stats->misses));
+  result->Set(String::NewSymbol("hits"), Integer::NewFromUnsigned(
+      stats->draws > stats->misses ? stats->draws - stats->misses : 0));
+
+  NanReturnValue(result);
+}
+
+NAN_METHOD(QGraphicsItemWrap::ResetCacheStats) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::resetCacheStats: item was removed");
+
+  *Stats(q) = QGraphicsItemStats();
+
+  NanReturnUndefined();
+}
+
+// Property names accepted by animate() and stopAnimations()
+static int AnimatedProperty(Handle<Value> name) {
+  QString s = qt_v8::ToQString(name->ToString());
+  if (s == "x") return ItemAnimator::X;
+  if (s == "y") return ItemAnimator::Y;
+  if (s == "rotation") return ItemAnimator::Rotation;
+  if (s == "scale") return ItemAnimator::Scale;
+  if (s == "opacity") return ItemAnimator::Opacity;
+  if (s == "zValue") return ItemAnimator::ZValue;
+  return -1;
+}
+
+// Supported versions:
+//   animate(String property, Number to, Number duration)
+//   animate(String property, Array keyframes, Number duration)
+//   animate(..., Number duration, EasingCurve easing)
+//   animate(..., Number duration, EasingCurve easing, Number loops)
+//
+// property is one of x, y, rotation, scale, opacity, zValue. keyframes
+// are [progress, value] pairs with progress ascending from exactly 0 to
+// exactly 1; a single number animates from the current value. loops
+// defaults to 1, -1 repeats until stopped. Frames are computed natively
+// without calling into JS, as long as the event loop keeps running
+NAN_METHOD(QGraphicsItemWrap::Animate) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::animate: item was removed");
+
+  int property = AnimatedProperty(args[0]);
+  if (property < 0)
+    return NanThrowTypeError("QGraphicsItem::animate: unknown property");
+
+  if (!args[2]->IsNumber())
+    return NanThrowTypeError("QGraphicsItem::animate: bad arguments");
+
+  ItemAnimator::Keyframes keys;
+  ItemAnimator::Property p = static_cast<ItemAnimator::Property>(property);
+
+  if (args[1]->IsNumber()) {
+    keys.append(qMakePair(qreal(0), ItemAnimator::value(q, p)));
+    keys.append(qMakePair(qreal(1), qreal(args[1]->NumberValue())));
+  } else if (args[1]->IsArray()) {
+    Local<Array> array = Local<Array>::Cast(args[1]);
+    for (uint32_t i = 0; i < array->Length(); ++i) {
+      Local<Value> key = array->Get(i);
+      if (!key->IsArray())
+        return NanThrowTypeError("QGraphicsItem::animate: bad keyframe");
+      Local<Object> pair = key->ToObject();
+      qreal progress = pair->Get(0)->NumberValue();
+      if (!(progress >= 0 && progress <= 1) ||
+          (!keys.isEmpty() && progress < keys.last().first))
+        return NanThrowRangeError("QGraphicsItem::animate: keyframes must "
+                                  "ascend from 0 to 1");
+      keys.append(qMakePair(progress, qreal(pair->Get(1)->NumberValue())));
+    }
+    if (keys.size() < 2)
+      return NanThrowRangeError("QGraphicsItem::animate: need at least "
+                                "two keyframes");
+    if (keys.first().first != 0 || keys.last().first != 1)
+      return NanThrowRangeError("QGraphicsItem::animate: keyframes must "
+                                "ascend from 0 to 1");
+  } else {
+    return NanThrowTypeError("QGraphicsItem::animate: bad arguments");
+  }
+
+  QEasingCurve easing;
+  if (args.Length() > 3) {
+    int type = args[3]->Int32Value();
+    if (type < QEasingCurve::Linear || type >= QEasingCurve::Custom)
+      return NanThrowRangeError("QGraphicsItem::animate: unknown easing curve");
+    easing.setType(static_cast<QEasingCurve::Type>(type));
+  }
+
+  int loops = 1;
+  if (args.Length() > 4) {
+    loops = args[4]->Int32Value();
+    if (loops == 0 || loops < -1)
+      return NanThrowRangeError("QGraphicsItem::animate: bad loop count");
+  }
+
+  ItemAnimator::instance()->start(q, p, keys, args[2]->Int32Value(),
+                                  easing, loops);
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   stopAnimations()
+//   stopAnimations(String property)
+// The property keeps its current value
+NAN_METHOD(QGraphicsItemWrap::StopAnimations) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    return NanThrowError("QGraphicsItem::stopAnimations: item was removed");
+
+  int property = -1;
+  if (args.Length() > 0) {
+    property = AnimatedProperty(args[0]);
+    if (property < 0)
+      return NanThrowTypeError("QGraphicsItem::stopAnimations: unknown property");
+  }
+
+  ItemAnimator::instance()->stop(q, property);
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsItemWrap::IsAnimating) {
+  NanScope();
+
+  QGraphicsItemWrap* w = node::ObjectWrap::Unwrap<QGraphicsItemWrap>(args.This());
+  QGraphicsItem* q = w->GetWrapped();
+
+  if (!q)
+    NanReturnValue(False());
+
+  NanReturnValue(Boolean::New(ItemAnimator::instance()->isAnimating(q)));
+}
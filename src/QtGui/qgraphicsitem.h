@@ -0,0 +1,122 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef QGRAPHICSITEMWRAP_H
+#define QGRAPHICSITEMWRAP_H
+
+#include <node.h>
+#include <QGraphicsItem>
+#include <nan.h>
+
+//
+// QGraphicsItemStats
+// Paint counters kept on every item the binding creates. misses counts
+// paint() calls made while the item was cached (i.e. cache refills);
+// draws counts view repaints that covered the cached item
+//
+struct QGraphicsItemStats {
+  QGraphicsItemStats() : paints(0), misses(0), draws(0) {}
+  quint32 paints;
+  quint32 misses;
+  quint32 draws;
+};
+
+//
+// QGraphicsItemImpl()
+// Extends a stock item class to count calls to paint()
+//
+template <class T>
+class QGraphicsItemImpl : public T, public QGraphicsItemStats {
+ public:
+  void paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+             QWidget* widget) {
+    ++paints;
+    if (T::cacheMode() != QGraphicsItem::NoCache)
+      ++misses;
+    T::paint(painter, option, widget);
+  }
+};
+
+//
+// QGraphicsItemWrap()
+// Wraps any item created by QGraphicsScene's addXxx() methods. Items are
+// owned by their scene; the wrapper is detached (and its methods throw)
+// once the item is removed or the scene destroyed
+//
+class QGraphicsItemWrap : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+  static v8::Handle<v8::Object> NewInstance(QGraphicsItem* q);
+  QGraphicsItem* GetWrapped() const { return q_; };
+  // Detaching (q == NULL) also stops the item's animations
+  void SetWrapped(QGraphicsItem* q);
+
+  // Counters of an item created by QGraphicsSceneWrap, NULL otherwise
+  static QGraphicsItemStats* Stats(QGraphicsItem* q);
+
+  // True once any item has had caching turned on; views skip cache
+  // accounting until then
+  static bool cacheUsed;
+
+ private:
+  QGraphicsItemWrap();
+  ~QGraphicsItemWrap();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(Type);
+  static NAN_METHOD(SetPos);
+  static NAN_METHOD(X);
+  static NAN_METHOD(Y);
+  static NAN_METHOD(SetZValue);
+  static NAN_METHOD(ZValue);
+  static NAN_METHOD(SetRotation);
+  static NAN_METHOD(Rotation);
+  static NAN_METHOD(SetScale);
+  static NAN_METHOD(Scale);
+  static NAN_METHOD(SetOpacity);
+  static NAN_METHOD(Opacity);
+  static NAN_METHOD(SetVisible);
+  static NAN_METHOD(IsVisible);
+  static NAN_METHOD(SetPen);
+  static NAN_METHOD(SetBrush);
+  static NAN_METHOD(SetCacheMode);
+  static NAN_METHOD(CacheMode);
+  static NAN_METHOD(CacheStats);
+  static NAN_METHOD(ResetCacheStats);
+  static NAN_METHOD(Animate);
+  static NAN_METHOD(StopAnimations);
+  static NAN_METHOD(IsAnimating);
+
+  // Wrapped object, not owned
+  QGraphicsItem* q_;
+};
+
+#endif
@@ -0,0 +1,375 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <node.h>
+#include <QPainter>
+#include "../qt_v8.h"
+#include "qgraphicsscene.h"
+#include "qgraphicsitem.h"
+#include "qpen.h"
+#include "qbrush.h"
+#include "qpainterpath.h"
+#include "qpixmap.h"
+#include "qimage.h"
+#include "qfont.h"
+
+using namespace v8;
+
+Persistent<Function> QGraphicsSceneWrap::constructor;
+
+// Supported implementations:
+//   QGraphicsScene ( )
+//   QGraphicsScene ( qreal x, qreal y, qreal width, qreal height )
+QGraphicsSceneWrap::QGraphicsSceneWrap(_NAN_METHOD_ARGS) : q_(NULL) {
+  if (args.Length() >= 4) {
+    q_ = new QGraphicsScene(args[0]->NumberValue(), args[1]->NumberValue(),
+                            args[2]->NumberValue(), args[3]->NumberValue());
+  } else {
+    q_ = new QGraphicsScene;
+  }
+}
+
+QGraphicsSceneWrap::~QGraphicsSceneWrap() {
+  // Items die with the scene; detach their wrappers first
+  QHash<QGraphicsItem*, Persistent<Object> >::iterator it;
+  for (it = items_.begin(); it != items_.end(); ++it) {
+    ObjectWrap::Unwrap<QGraphicsItemWrap>(
+        NanPersistentToLocal(it.value()))->SetWrapped(NULL);
+    NanDispose(it.value());
+  }
+
+  delete q_;
+}
+
+void QGraphicsSceneWrap::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("QGraphicsScene"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addRect"),
+      FunctionTemplate::New(AddRect)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addPath"),
+      FunctionTemplate::New(AddPath)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addPixmap"),
+      FunctionTemplate::New(AddPixmap)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addSimpleText"),
+      FunctionTemplate::New(AddSimpleText)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("removeItem"),
+      FunctionTemplate::New(RemoveItem)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("clear"),
+      FunctionTemplate::New(Clear)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("itemCount"),
+      FunctionTemplate::New(ItemCount)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("itemsAt"),
+      FunctionTemplate::New(ItemsAt)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("items"),
+      FunctionTemplate::New(Items)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setSceneRect"),
+      FunctionTemplate::New(SetSceneRect)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("render"),
+      FunctionTemplate::New(Render)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("QGraphicsScene"), tpl->GetFunction());
+}
+
+NAN_METHOD(QGraphicsSceneWrap::New) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = new QGraphicsSceneWrap(args);
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+// Adds a freshly created item and keeps its wrapper for hit tests.
+// Items are created here rather than through QGraphicsScene::addXxx() so
+// that they count their paints (see QGraphicsItemImpl)
+Handle<Value> QGraphicsSceneWrap::adopt(QGraphicsItem* item) {
+  NanScope();
+
+  q_->addItem(item);
+
+  Handle<Object> handle = QGraphicsItemWrap::NewInstance(item);
+  NanAssignPersistent(Object, items_[item], handle);
+
+  return scope.Close(handle);
+}
+
+Handle<Array> QGraphicsSceneWrap::wrapItems(const QList<QGraphicsItem*>& items) {
+  NanScope();
+
+  Local<Array> array = Array::New(items.size());
+  int n = 0;
+  for (int i = 0; i < items.size(); ++i) {
+    QHash<QGraphicsItem*, Persistent<Object> >::const_iterator it =
+        items_.constFind(items[i]);
+    if (it != items_.constEnd())
+      array->Set(n++, NanPersistentToLocal(it.value()));
+  }
+
+  return scope.Close(array);
+}
+
+// Optional QPen and QBrush arguments starting at args[first]
+static void ShapeStyle(_NAN_METHOD_ARGS, int first,
+                       QPen* pen, QBrush* brush) {
+  for (int i = first; i < args.Length() && i < first + 2; ++i) {
+    if (!args[i]->IsObject())
+      continue;
+
+    QString constructor_name =
+      qt_v8::ToQString(args[i]->ToObject()->GetConstructorName());
+    if (constructor_name == "QPen")
+      *pen = *node::ObjectWrap::Unwrap<QPenWrap>(args[i]->ToObject())->GetWrapped();
+    else if (constructor_name == "QBrush")
+      *brush = *node::ObjectWrap::Unwrap<QBrushWrap>(args[i]->ToObject())->GetWrapped();
+  }
+}
+
+// Supported versions:
+//   addRect(x, y, w, h)
+//   addRect(x, y, w, h, QPen pen)
+//   addRect(x, y, w, h, QPen pen, QBrush brush)
+NAN_METHOD(QGraphicsSceneWrap::AddRect) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+  QGraphicsScene* q = w->GetWrapped();
+
+  QPen pen;
+  QBrush brush;
+  ShapeStyle(args, 4, &pen, &brush);
+
+  QGraphicsItemImpl<QGraphicsRectItem>* item =
+      new QGraphicsItemImpl<QGraphicsRectItem>;
+  item->setRect(args[0]->NumberValue(), args[1]->NumberValue(),
+                args[2]->NumberValue(), args[3]->NumberValue());
+  item->setPen(pen);
+  item->setBrush(brush);
+
+  NanReturnValue(w->adopt(item));
+}
+
+// Supported versions:
+//   addPath(QPainterPath path)
+//   addPath(QPainterPath path, QPen pen)
+//   addPath(QPainterPath path, QPen pen, QBrush brush)
+NAN_METHOD(QGraphicsSceneWrap::AddPath) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+
+  if (!args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QPainterPath")
+    return NanThrowTypeError("QGraphicsScene::addPath: bad arguments");
+
+  QPainterPath* path =
+      ObjectWrap::Unwrap<QPainterPathWrap>(args[0]->ToObject())->GetWrapped();
+
+  QPen pen;
+  QBrush brush;
+  ShapeStyle(args, 1, &pen, &brush);
+
+  QGraphicsItemImpl<QGraphicsPathItem>* item =
+      new QGraphicsItemImpl<QGraphicsPathItem>;
+  item->setPath(*path);
+  item->setPen(pen);
+  item->setBrush(brush);
+
+  NanReturnValue(w->adopt(item));
+}
+
+// Supported versions:
+//   addPixmap(QPixmap pixmap)
+//   addPixmap(QImage image)
+NAN_METHOD(QGraphicsSceneWrap::AddPixmap) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+
+  if (!args[0]->IsObject())
+    return NanThrowTypeError("QGraphicsScene::addPixmap: bad arguments");
+
+  QString constructor_name =
+    qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+
+  QPixmap pixmap;
+  if (constructor_name == "QPixmap") {
+    pixmap = *ObjectWrap::Unwrap<QPixmapWrap>(args[0]->ToObject())->GetWrapped();
+  } else if (constructor_name == "QImage") {
+    pixmap = QPixmap::fromImage(
+        *ObjectWrap::Unwrap<QImageWrap>(args[0]->ToObject())->GetWrapped());
+  } else {
+    return NanThrowTypeError("QGraphicsScene::addPixmap: bad arguments");
+  }
+
+  QGraphicsItemImpl<QGraphicsPixmapItem>* item =
+      new QGraphicsItemImpl<QGraphicsPixmapItem>;
+  item->setPixmap(pixmap);
+
+  NanReturnValue(w->adopt(item));
+}
+
+// Supported versions:
+//   addSimpleText(String text)
+//   addSimpleText(String text, QFont font)
+//
+// QGraphicsSimpleTextItem rather than QGraphicsTextItem: no QTextDocument
+// per item, which matters for diagrams with many labels
+NAN_METHOD(QGraphicsSceneWrap::AddSimpleText) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+
+  QFont font;
+  if (args[1]->IsObject() &&
+      qt_v8::ToQString(args[1]->ToObject()->GetConstructorName()) == "QFont")
+    font = *ObjectWrap::Unwrap<QFontWrap>(args[1]->ToObject())->GetWrapped();
+
+  QGraphicsItemImpl<QGraphicsSimpleTextItem>* item =
+      new QGraphicsItemImpl<QGraphicsSimpleTextItem>;
+  item->setText(qt_v8::ToQString(args[0]->ToString()));
+  item->setFont(font);
+
+  NanReturnValue(w->adopt(item));
+}
+
+// The item is deleted; its wrapper's methods throw afterwards
+NAN_METHOD(QGraphicsSceneWrap::RemoveItem) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+  QGraphicsScene* q = w->GetWrapped();
+
+  if (!args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QGraphicsItem")
+    return NanThrowTypeError("QGraphicsScene::removeItem: bad arguments");
+
+  QGraphicsItemWrap* item_wrap =
+      ObjectWrap::Unwrap<QGraphicsItemWrap>(args[0]->ToObject());
+  QGraphicsItem* item = item_wrap->GetWrapped();
+
+  if (!item || !w->items_.contains(item))
+    return NanThrowError("QGraphicsScene::removeItem: item is not in this scene");
+
+  q->removeItem(item);
+  delete item;
+  item_wrap->SetWrapped(NULL);
+  NanDispose(w->items_[item]);
+  w->items_.remove(item);
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsSceneWrap::Clear) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+  QGraphicsScene* q = w->GetWrapped();
+
+  QHash<QGraphicsItem*, Persistent<Object> >::iterator it;
+  for (it = w->items_.begin(); it != w->items_.end(); ++it) {
+    ObjectWrap::Unwrap<QGraphicsItemWrap>(
+        NanPersistentToLocal(it.value()))->SetWrapped(NULL);
+    NanDispose(it.value());
+  }
+  w->items_.clear();
+
+  q->clear();
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsSceneWrap::ItemCount) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+
+  NanReturnValue(Integer::New(w->items_.size()));
+}
+
+// Items under the scene point (x, y), topmost first
+NAN_METHOD(QGraphicsSceneWrap::ItemsAt) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+  QGraphicsScene* q = w->GetWrapped();
+
+  QPointF pos(args[0]->NumberValue(), args[1]->NumberValue());
+
+  NanReturnValue(w->wrapItems(q->items(pos)));
+}
+
+// Items intersecting the scene rectangle (x, y, w, h), topmost first
+NAN_METHOD(QGraphicsSceneWrap::Items) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+  QGraphicsScene* q = w->GetWrapped();
+
+  QRectF rect(args[0]->NumberValue(), args[1]->NumberValue(),
+              args[2]->NumberValue(), args[3]->NumberValue());
+
+  NanReturnValue(w->wrapItems(q->items(rect)));
+}
+
+NAN_METHOD(QGraphicsSceneWrap::SetSceneRect) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+  QGraphicsScene* q = w->GetWrapped();
+
+  q->setSceneRect(args[0]->NumberValue(), args[1]->NumberValue(),
+                  args[2]->NumberValue(), args[3]->NumberValue());
+
+  NanReturnUndefined();
+}
+
+// Paints the whole scene into a QImage, scaled to fit. Works without
+// a view, e.g. in headless applications
+NAN_METHOD(QGraphicsSceneWrap::Render) {
+  NanScope();
+
+  QGraphicsSceneWrap* w = ObjectWrap::Unwrap<QGraphicsSceneWrap>(args.This());
+  QGraphicsScene* q = w->GetWrapped();
+
+  if (!args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QImage")
+    return NanThrowTypeError("QGraphicsScene::render: bad arguments");
+
+  QImage* image = ObjectWrap::Unwrap<QImageWrap>(args[0]->ToObject())->GetWrapped();
+
+  QPainter painter(image);
+  q->render(&painter);
+
+  NanReturnUndefined();
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef QGRAPHICSSCENEWRAP_H
+#define QGRAPHICSSCENEWRAP_H
+
+#include <node.h>
+#include <QGraphicsScene>
+#include <QHash>
+#include <nan.h>
+
+//
+// QGraphicsSceneWrap()
+// Items are looked up through the scene's BSP index, so itemsAt() and
+// items() cost O(log n) rather than a scan of every item. The scene keeps
+// the JS wrapper of each item it created alive, and hands the same object
+// back from hit tests
+//
+class QGraphicsSceneWrap : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+  QGraphicsScene* GetWrapped() const { return q_; };
+
+  // Wrappers for items of this scene, in the given order
+  v8::Handle<v8::Array> wrapItems(const QList<QGraphicsItem*>& items);
+
+ private:
+  QGraphicsSceneWrap(_NAN_METHOD_ARGS);
+  ~QGraphicsSceneWrap();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  v8::Handle<v8::Value> adopt(QGraphicsItem* item);
+
+  // Wrapped methods
+  static NAN_METHOD(AddRect);
+  static NAN_METHOD(AddPath);
+  static NAN_METHOD(AddPixmap);
+  static NAN_METHOD(AddSimpleText);
+  static NAN_METHOD(RemoveItem);
+  static NAN_METHOD(Clear);
+  static NAN_METHOD(ItemCount);
+  static NAN_METHOD(ItemsAt);
+  static NAN_METHOD(Items);
+  static NAN_METHOD(SetSceneRect);
+  static NAN_METHOD(Render);
+
+  // Wrapped object
+  QGraphicsScene* q_;
+  QHash<QGraphicsItem*, v8::Persistent<v8::Object> > items_;
+};
+
+#endif
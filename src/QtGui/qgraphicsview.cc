@@ -0,0 +1,312 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <node.h>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include "../qt_v8.h"
+#include "../QtCore/qpointf.h"
+#include "qgraphicsview.h"
+#include "qgraphicsscene.h"
+#include "qgraphicsitem.h"
+#include "qapplication.h"
+#include "qwidget.h"
+#include "qmouseevent.h"
+
+using namespace v8;
+
+Persistent<Function> QGraphicsViewWrap::constructor;
+
+//
+// QGraphicsViewImpl()
+//
+
+QGraphicsViewImpl::QGraphicsViewImpl(QGraphicsScene* scene, QWidget* parent)
+    : QGraphicsView(scene, parent) {
+}
+
+QGraphicsViewImpl::~QGraphicsViewImpl() {
+  NanDispose(mousePressCallback_);
+  NanDispose(mouseReleaseCallback_);
+  NanDispose(mouseMoveCallback_);
+}
+
+void QGraphicsViewImpl::callback(const Persistent<Function>& cb,
+                                 QMouseEvent* e) {
+  if (cb.IsEmpty())
+    return;
+
+  NanScope();
+
+  const unsigned argc = 1;
+  Handle<Value> argv[argc] = {
+    QMouseEventWrap::NewInstance(*e)
+  };
+
+  NanPersistentToLocal(cb)->Call(Context::GetCurrent()->Global(), argc, argv);
+}
+
+void QGraphicsViewImpl::mousePressEvent(QMouseEvent* e) {
+  callback(mousePressCallback_, e);
+  QGraphicsView::mousePressEvent(e);
+}
+
+void QGraphicsViewImpl::mouseReleaseEvent(QMouseEvent* e) {
+  callback(mouseReleaseCallback_, e);
+  QGraphicsView::mouseReleaseEvent(e);
+}
+
+void QGraphicsViewImpl::mouseMoveEvent(QMouseEvent* e) {
+  callback(mouseMoveCallback_, e);
+  QGraphicsView::mouseMoveEvent(e);
+}
+
+// Every cached item under the exposed rect is about to be drawn, either
+// from its cache or by a paint() that refills it
+void QGraphicsViewImpl::paintEvent(QPaintEvent* e) {
+  if (QGraphicsItemWrap::cacheUsed) {
+    QList<QGraphicsItem*> exposed = items(e->rect());
+    for (int i = 0; i < exposed.size(); ++i) {
+      QGraphicsItem* item = exposed[i];
+      if (item->cacheMode() == QGraphicsItem::NoCache || !item->isVisible())
+        continue;
+      QGraphicsItemStats* stats = QGraphicsItemWrap::Stats(item);
+      if (stats)
+        ++stats->draws;
+    }
+  }
+
+  QGraphicsView::paintEvent(e);
+}
+
+//
+// QGraphicsViewWrap()
+//
+
+QGraphicsViewWrap::QGraphicsViewWrap(QGraphicsSceneWrap* scene,
+                                     QWidget* parent) : scene_(scene) {
+  q_ = new QGraphicsViewImpl(scene->GetWrapped(), parent);
+  q_->setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+}
+
+QGraphicsViewWrap::~QGraphicsViewWrap() {
+  delete q_;
+  NanDispose(sceneHandle_);
+}
+
+void QGraphicsViewWrap::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("QGraphicsView"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Wrapped methods
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("resize"),
+      FunctionTemplate::New(Resize)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("show"),
+      FunctionTemplate::New(Show)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("close"),
+      FunctionTemplate::New(Close)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("centerOn"),
+      FunctionTemplate::New(CenterOn)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("scale"),
+      FunctionTemplate::New(Scale)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("mapToScene"),
+      FunctionTemplate::New(MapToScene)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("itemsAt"),
+      FunctionTemplate::New(ItemsAt)->GetFunction());
+
+  // Events
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("mousePressEvent"),
+      FunctionTemplate::New(MousePressEvent)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("mouseReleaseEvent"),
+      FunctionTemplate::New(MouseReleaseEvent)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("mouseMoveEvent"),
+      FunctionTemplate::New(MouseMoveEvent)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("QGraphicsView"), tpl->GetFunction());
+}
+
+// Supported implementations:
+//   QGraphicsView ( QGraphicsScene scene )
+//   QGraphicsView ( QGraphicsScene scene, QWidget parent )
+NAN_METHOD(QGraphicsViewWrap::New) {
+  NanScope();
+
+  if (!QApplicationWrap::HasGui())
+    return NanThrowError("QGraphicsView::QGraphicsView: application was created without gui");
+
+  if (!args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QGraphicsScene")
+    return NanThrowTypeError("QGraphicsView::QGraphicsView: bad arguments");
+
+  QGraphicsSceneWrap* scene =
+      ObjectWrap::Unwrap<QGraphicsSceneWrap>(args[0]->ToObject());
+
+  QWidget* parent = NULL;
+  if (args[1]->IsObject() &&
+      qt_v8::ToQString(args[1]->ToObject()->GetConstructorName()) == "QWidget")
+    parent = ObjectWrap::Unwrap<QWidgetWrap>(args[1]->ToObject())->GetWrapped();
+
+  QGraphicsViewWrap* w = new QGraphicsViewWrap(scene, parent);
+  NanAssignPersistent(Object, w->sceneHandle_, args[0]->ToObject());
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+NAN_METHOD(QGraphicsViewWrap::Resize) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  q->resize(args[0]->NumberValue(), args[1]->NumberValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsViewWrap::Show) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  q->show();
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsViewWrap::Close) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  q->close();
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsViewWrap::CenterOn) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  q->centerOn(args[0]->NumberValue(), args[1]->NumberValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QGraphicsViewWrap::Scale) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  q->scale(args[0]->NumberValue(), args[1]->NumberValue());
+
+  NanReturnUndefined();
+}
+
+// View coordinates to scene coordinates, as a QPointF
+NAN_METHOD(QGraphicsViewWrap::MapToScene) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  NanReturnValue(QPointFWrap::NewInstance(
+      q->mapToScene(args[0]->IntegerValue(), args[1]->IntegerValue())));
+}
+
+// Items under the view point (x, y), topmost first. Same objects as
+// returned by the scene's addXxx() methods
+NAN_METHOD(QGraphicsViewWrap::ItemsAt) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  NanReturnValue(w->scene_->wrapItems(
+      q->items(args[0]->IntegerValue(), args[1]->IntegerValue())));
+}
+
+//
+// MousePressEvent()
+// Binds a callback to Qt's event
+//
+NAN_METHOD(QGraphicsViewWrap::MousePressEvent) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  NanDispose(q->mousePressCallback_);
+  if (args[0]->IsFunction())
+    NanAssignPersistent(Function, q->mousePressCallback_, Local<Function>::Cast(args[0]));
+
+  NanReturnUndefined();
+}
+
+//
+// MouseReleaseEvent()
+// Binds a callback to Qt's event
+//
+NAN_METHOD(QGraphicsViewWrap::MouseReleaseEvent) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  NanDispose(q->mouseReleaseCallback_);
+  if (args[0]->IsFunction())
+    NanAssignPersistent(Function, q->mouseReleaseCallback_, Local<Function>::Cast(args[0]));
+
+  NanReturnUndefined();
+}
+
+//
+// MouseMoveEvent()
+// Binds a callback to Qt's event
+//
+NAN_METHOD(QGraphicsViewWrap::MouseMoveEvent) {
+  NanScope();
+
+  QGraphicsViewWrap* w = ObjectWrap::Unwrap<QGraphicsViewWrap>(args.This());
+  QGraphicsViewImpl* q = w->GetWrapped();
+
+  NanDispose(q->mouseMoveCallback_);
+  if (args[0]->IsFunction())
+    NanAssignPersistent(Function, q->mouseMoveCallback_, Local<Function>::Cast(args[0]));
+
+  NanReturnUndefined();
+}
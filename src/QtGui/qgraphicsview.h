@@ -0,0 +1,99 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef QGRAPHICSVIEWWRAP_H
+#define QGRAPHICSVIEWWRAP_H
+
+#include <node.h>
+#include <QGraphicsView>
+#include <nan.h>
+
+class QGraphicsSceneWrap;
+
+//
+// QGraphicsViewImpl()
+// Extends QGraphicsView to pass mouse events on to JS before the view's
+// own handling (item selection, dragging), and to count draws of cached
+// items for QGraphicsItem.cacheStats()
+//
+class QGraphicsViewImpl : public QGraphicsView {
+ public:
+  QGraphicsViewImpl(QGraphicsScene* scene, QWidget* parent);
+  ~QGraphicsViewImpl();
+  v8::Persistent<v8::Function> mousePressCallback_;
+  v8::Persistent<v8::Function> mouseReleaseCallback_;
+  v8::Persistent<v8::Function> mouseMoveCallback_;
+
+ private:
+  void callback(const v8::Persistent<v8::Function>& cb, QMouseEvent* e);
+  void mousePressEvent(QMouseEvent* e);
+  void mouseReleaseEvent(QMouseEvent* e);
+  void mouseMoveEvent(QMouseEvent* e);
+  void paintEvent(QPaintEvent* e);
+};
+
+//
+// QGraphicsViewWrap()
+// Repaints only what changed in the scene (MinimalViewportUpdate)
+//
+class QGraphicsViewWrap : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+  QGraphicsViewImpl* GetWrapped() const { return q_; };
+
+ private:
+  QGraphicsViewWrap(QGraphicsSceneWrap* scene, QWidget* parent);
+  ~QGraphicsViewWrap();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(Resize);
+  static NAN_METHOD(Show);
+  static NAN_METHOD(Close);
+  static NAN_METHOD(CenterOn);
+  static NAN_METHOD(Scale);
+  static NAN_METHOD(MapToScene);
+  static NAN_METHOD(ItemsAt);
+
+  // QUIRK
+  // Event binding, as for QWidget
+  static NAN_METHOD(MousePressEvent);
+  static NAN_METHOD(MouseReleaseEvent);
+  static NAN_METHOD(MouseMoveEvent);
+
+  // Wrapped object
+  QGraphicsViewImpl* q_;
+
+  // The view keeps its scene alive
+  QGraphicsSceneWrap* scene_;
+  v8::Persistent<v8::Object> sceneHandle_;
+};
+
+#endif
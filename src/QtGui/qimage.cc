@@ -28,25 +28,119 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <node.h>
+#include <node_buffer.h>
+#include <QPainter>
 #include "qimage.h"
+#include "qcolor.h"
 #include "../qt_v8.h"
+#include "../Extras/imagebuffer.h"
+#include "../Extras/pixelops.h"
+#include "../Extras/pngsave.h"
+#include "../Extras/rawimage.h"
+#include "../Extras/resampler.h"
 
 using namespace v8;
 
 Persistent<Function> QImageWrap::constructor;
 
+//
+// ResampleWorker
+// Runs Resampler::resample() off the main thread for scaledAsync(). The
+// source is an implicitly shared copy, so JS may keep using (or drop) the
+// original while the resize runs
+//
+class ResampleWorker : public NanAsyncWorker {
+ public:
+  ResampleWorker(NanCallback* callback, const QImage& image, int width,
+                 int height, Resampler::Filter filter)
+      : NanAsyncWorker(callback), image_(image), width_(width),
+        height_(height), filter_(filter) {}
+
+  void Execute() {
+    result_ = Resampler::resample(image_, width_, height_, filter_);
+  }
+
+  void HandleOKCallback() {
+    NanScope();
+
+    Local<Value> argv[2];
+    if (result_.isNull()) {
+      argv[0] = Exception::Error(
+          String::New("QImage::ScaledAsync: could not resample image"));
+      argv[1] = Local<Value>::New(Null());
+    } else {
+      argv[0] = Local<Value>::New(Null());
+      argv[1] = Local<Value>::New(QImageWrap::NewInstance(result_));
+    }
+    callback->Run(2, argv);
+  }
+
+ private:
+  QImage image_;
+  int width_;
+  int height_;
+  Resampler::Filter filter_;
+  QImage result_;
+};
+
 // Supported implementations:
 //   QImage ( )
+//   QImage ( int width, int height, QImage::Format format )
 //   QImage ( QString filename )
-QImageWrap::QImageWrap(_NAN_METHOD_ARGS) {
+//   QImage ( Buffer data, int width, int height, QImage::Format format,
+//            int bytesPerLine )
+QImageWrap::QImageWrap(_NAN_METHOD_ARGS) : q_(NULL) {
+  if (node::Buffer::HasInstance(args[0])) {
+    // QImage ( Buffer data, int width, int height, QImage::Format format,
+    //          int bytesPerLine )
+    // Copies the pixels once, straight from the Buffer's memory. Data must
+    // already be in the given format's layout; bytesPerLine defaults to
+    // tightly packed rows. Leaves a null image if the Buffer is too short
+    int width = args[1]->IntegerValue();
+    int height = args[2]->IntegerValue();
+    QImage::Format format = args[3]->IsNumber() ?
+        (QImage::Format)args[3]->IntegerValue() :
+        QImage::Format_ARGB32_Premultiplied;
+
+    q_ = new QImage(width, height, format);
+    if (q_->isNull())
+      return;
+
+    int rowBytes = (q_->depth() * width + 7) / 8;
+    int stride = args[4]->IsNumber() ? args[4]->IntegerValue() : rowBytes;
+    const char* data = node::Buffer::Data(args[0]->ToObject());
+    size_t length = node::Buffer::Length(args[0]->ToObject());
+
+    if (stride < rowBytes ||
+        length < (size_t)stride * (height - 1) + rowBytes) {
+      *q_ = QImage();
+      return;
+    }
+
+    for (int y = 0; y < height; ++y)
+      memcpy(q_->scanLine(y), data + (size_t)stride * y, rowBytes);
+    return;
+  }
+
   if (args[0]->IsString()) {
     // QImage ( QString filename )
     q_ = new QImage(qt_v8::ToQString(args[0]->ToString()));
     return;
   }
 
+  if (args[0]->IsNumber() && args[1]->IsNumber()) {
+    // QImage ( int width, int height, QImage::Format format )
+    QImage::Format format = args[2]->IsNumber() ?
+        (QImage::Format)args[2]->IntegerValue() :
+        QImage::Format_ARGB32_Premultiplied;
+
+    q_ = new QImage(args[0]->IntegerValue(), args[1]->IntegerValue(),
+                    format);
+    return;
+  }
+
   // QImage ( )
-  q_ = new QImage(qt_v8::ToQString(args[0]->ToString()));
+  q_ = new QImage;
 }
 
 QImageWrap::~QImageWrap() {
@@ -54,6 +148,9 @@ QImageWrap::~QImageWrap() {
 }
 
 void QImageWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QImage"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("QImage"));
@@ -62,6 +159,44 @@ void QImageWrap::Initialize(Handle<Object> target) {
   // Prototype
   tpl->PrototypeTemplate()->Set(String::NewSymbol("isNull"),
       FunctionTemplate::New(IsNull)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("width"),
+      FunctionTemplate::New(Width)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("height"),
+      FunctionTemplate::New(Height)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("format"),
+      FunctionTemplate::New(Format)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("pixel"),
+      FunctionTemplate::New(Pixel)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("saveRaw"),
+      FunctionTemplate::New(SaveRaw)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("loadRaw"),
+      FunctionTemplate::New(LoadRaw)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("convertToFormat"),
+      FunctionTemplate::New(ConvertToFormat)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("premultiply"),
+      FunctionTemplate::New(Premultiply)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("unpremultiply"),
+      FunctionTemplate::New(Unpremultiply)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("rgbSwapped"),
+      FunctionTemplate::New(RgbSwapped)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("fill"),
+      FunctionTemplate::New(Fill)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("blend"),
+      FunctionTemplate::New(Blend)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("colorMatrix"),
+      FunctionTemplate::New(ColorMatrix)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("scaled"),
+      FunctionTemplate::New(Scaled)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("scaledAsync"),
+      FunctionTemplate::New(ScaledAsync)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("save"),
+      FunctionTemplate::New(Save)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("saveAsync"),
+      FunctionTemplate::New(SaveAsync)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("toBuffer"),
+      FunctionTemplate::New(ToBuffer)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("toBufferAsync"),
+      FunctionTemplate::New(ToBufferAsync)->GetFunction());
 
   NanAssignPersistent(Function, constructor, tpl->GetFunction());
   target->Set(String::NewSymbol("QImage"), tpl->GetFunction());
@@ -76,6 +211,18 @@ NAN_METHOD(QImageWrap::New) {
   NanReturnValue(args.This());
 }
 
+Handle<Value> QImageWrap::NewInstance(QImage q) {
+  NanScope();
+
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
+  Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
+  QImageWrap* w = node::ObjectWrap::Unwrap<QImageWrap>(instance);
+  w->SetWrapped(q);
+
+  return scope.Close(instance);
+}
+
 NAN_METHOD(QImageWrap::IsNull) {
   NanScope();
 
@@ -84,3 +231,379 @@ NAN_METHOD(QImageWrap::IsNull) {
 
   NanReturnValue(Boolean::New(q->isNull()));
 }
+
+NAN_METHOD(QImageWrap::Width) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->width()));
+}
+
+NAN_METHOD(QImageWrap::Height) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->height()));
+}
+
+NAN_METHOD(QImageWrap::Format) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->format()));
+}
+
+// QUIRK:
+// Returns the QRgb as an unsigned 0xAARRGGBB number
+NAN_METHOD(QImageWrap::Pixel) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  if (!q->valid(args[0]->IntegerValue(), args[1]->IntegerValue()))
+    return NanThrowRangeError("QImageWrap::Pixel: coordinates out of range");
+
+  NanReturnValue(Integer::NewFromUnsigned(
+      q->pixel(args[0]->IntegerValue(), args[1]->IntegerValue())));
+}
+
+// Writes the image in the memory-mappable RawImage format (see
+// Extras/rawimage.h). Throws on failure
+NAN_METHOD(QImageWrap::SaveRaw) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  if (!args[0]->IsString())
+    return NanThrowTypeError("QImage::SaveRaw: bad arguments");
+
+  QString error;
+  if (!RawImage::save(*q, qt_v8::ToQString(args[0]->ToString()), &error))
+    return NanThrowError(error.toUtf8().constData());
+
+  NanReturnUndefined();
+}
+
+// QUIRK:
+// The image is backed by a read-only mapping of the file shared with other
+// processes; painting into it first detaches a private copy. Throws on
+// failure
+NAN_METHOD(QImageWrap::LoadRaw) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+
+  if (!args[0]->IsString())
+    return NanThrowTypeError("QImage::LoadRaw: bad arguments");
+
+  QString error;
+  QImage image = RawImage::load(qt_v8::ToQString(args[0]->ToString()),
+                                &error);
+  if (image.isNull())
+    return NanThrowError(error.toUtf8().constData());
+
+  w->SetWrapped(image);
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QImageWrap::ConvertToFormat) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  if (!args[0]->IsNumber())
+    return NanThrowTypeError("QImage::ConvertToFormat: bad arguments");
+
+  NanReturnValue(QImageWrap::NewInstance(
+      q->convertToFormat((QImage::Format)args[0]->IntegerValue())));
+}
+
+// QUIRK:
+// Converts in place to Format_ARGB32_Premultiplied, the format the raster
+// engine paints fastest
+NAN_METHOD(QImageWrap::Premultiply) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  *q = q->convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+  NanReturnUndefined();
+}
+
+// QUIRK:
+// Converts in place to Format_ARGB32
+NAN_METHOD(QImageWrap::Unpremultiply) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  *q = q->convertToFormat(QImage::Format_ARGB32);
+
+  NanReturnUndefined();
+}
+
+// Swaps the red and blue channels, e.g. for RGBA byte data loaded as ARGB32
+NAN_METHOD(QImageWrap::RgbSwapped) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  NanReturnValue(QImageWrap::NewInstance(q->rgbSwapped()));
+}
+
+// Supported versions:
+//   fill(QColor color)
+//   fill(Qt::GlobalColor color)
+NAN_METHOD(QImageWrap::Fill) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  QString arg0_constructor;
+  if (args[0]->IsObject()) {
+    arg0_constructor =
+        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  }
+
+  if (arg0_constructor == "QColor") {
+    // fill(QColor color)
+    QColorWrap* color_wrap = ObjectWrap::Unwrap<QColorWrap>(
+        args[0]->ToObject());
+    q->fill(*color_wrap->GetWrapped());
+  } else if (args[0]->IsNumber()) {
+    // fill(Qt::GlobalColor color)
+    q->fill((Qt::GlobalColor)args[0]->IntegerValue());
+  } else {
+    return NanThrowTypeError("QImage::Fill: bad arguments");
+  }
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   blend(QImage source, int x, int y)
+//   blend(QImage source, int x, int y, qreal opacity)
+// Composites source over this image (SourceOver)
+NAN_METHOD(QImageWrap::Blend) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  if (!args[0]->IsObject() ||
+      qt_v8::ToQString(args[0]->ToObject()->GetConstructorName()) != "QImage")
+    return NanThrowTypeError("QImage::Blend: bad arguments");
+
+  QImage* source =
+      ObjectWrap::Unwrap<QImageWrap>(args[0]->ToObject())->GetWrapped();
+
+  if (q->isNull() || source->isNull())
+    NanReturnUndefined();
+
+  QPainter painter(q);
+  if (args[3]->IsNumber())
+    painter.setOpacity(args[3]->NumberValue());
+  painter.drawImage(args[1]->IntegerValue(), args[2]->IntegerValue(),
+                    *source);
+  painter.end();
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   colorMatrix(Array matrix)
+// matrix is 20 numbers, 4 rows of 5 (see Extras/pixelops.h)
+NAN_METHOD(QImageWrap::ColorMatrix) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  if (!args[0]->IsArray())
+    return NanThrowTypeError("QImage::ColorMatrix: bad arguments");
+
+  Local<Array> array = Local<Array>::Cast(args[0]);
+  if (array->Length() != 20)
+    return NanThrowRangeError("QImage::ColorMatrix: matrix must have 20 "
+                              "elements");
+
+  float matrix[20];
+  for (int i = 0; i < 20; ++i)
+    matrix[i] = array->Get(i)->NumberValue();
+
+  PixelOps::colorMatrix(*q, matrix);
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   scaled(int width, int height)
+//   scaled(int width, int height, ResampleFilter filter)
+// QUIRK:
+// Unlike Qt's scaled(), the third argument picks the resampling filter
+// (default Bilinear) and the aspect ratio is not preserved. Work is split
+// across the global thread pool
+NAN_METHOD(QImageWrap::Scaled) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  if (!args[0]->IsNumber() || !args[1]->IsNumber())
+    return NanThrowTypeError("QImage::Scaled: bad arguments");
+
+  Resampler::Filter filter = args[2]->IsNumber() ?
+      (Resampler::Filter)args[2]->IntegerValue() : Resampler::Bilinear;
+  if (filter < Resampler::Box || filter > Resampler::Lanczos)
+    return NanThrowRangeError("QImage::Scaled: unknown filter");
+
+  NanReturnValue(QImageWrap::NewInstance(Resampler::resample(
+      *q, args[0]->IntegerValue(), args[1]->IntegerValue(), filter)));
+}
+
+// Supported versions:
+//   scaledAsync(int width, int height, Function callback)
+//   scaledAsync(int width, int height, ResampleFilter filter,
+//               Function callback)
+// Calls back with (error, image) once the resize has run on libuv's pool
+NAN_METHOD(QImageWrap::ScaledAsync) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  int callback_index = args[2]->IsFunction() ? 2 : 3;
+  if (!args[0]->IsNumber() || !args[1]->IsNumber() ||
+      !args[callback_index]->IsFunction())
+    return NanThrowTypeError("QImage::ScaledAsync: bad arguments");
+
+  Resampler::Filter filter = callback_index == 3 ?
+      (Resampler::Filter)args[2]->IntegerValue() : Resampler::Bilinear;
+  if (filter < Resampler::Box || filter > Resampler::Lanczos)
+    return NanThrowRangeError("QImage::ScaledAsync: unknown filter");
+
+  NanCallback* callback =
+      new NanCallback(args[callback_index].As<Function>());
+  NanAsyncQueueWorker(new ResampleWorker(callback, *q,
+      args[0]->IntegerValue(), args[1]->IntegerValue(), filter));
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   save( QString file )
+//   save( QString file, Object pngOptions )
+// With options the file is always written as PNG by Extras/pngencoder:
+// { compression: 0-9, filter: 'none'|'sub'|'up'|'average'|'paeth'|
+// 'adaptive', threads: n }. Returns false on failure
+NAN_METHOD(QImageWrap::Save) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  QString file(qt_v8::ToQString(args[0]->ToString()));
+
+  if (!args[1]->IsObject())
+    NanReturnValue(Boolean::New( q->save(file) ));
+
+  PngSave::Options options;
+  QString error;
+  if (!PngSave::parseOptions(args[1], &options, &error))
+    return NanThrowTypeError(("QImage::Save: " + error).toUtf8().constData());
+
+  NanReturnValue(Boolean::New(
+      PngSave::save(*q, file, options, &error)));
+}
+
+// Supported versions:
+//   saveAsync( QString file, Function callback )
+//   saveAsync( QString file, Object pngOptions, Function callback )
+// Always PNG; options as for save(). Calls back with (error)
+NAN_METHOD(QImageWrap::SaveAsync) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  int callback_index = args[1]->IsFunction() ? 1 : 2;
+  if (!args[0]->IsString() || !args[callback_index]->IsFunction())
+    return NanThrowTypeError("QImage::SaveAsync: bad arguments");
+
+  PngSave::Options options;
+  QString error;
+  if (!PngSave::parseOptions(callback_index == 2 ? args[1] :
+                             Handle<Value>(Undefined()), &options, &error))
+    return NanThrowTypeError(("QImage::SaveAsync: " + error).toUtf8().constData());
+
+  PngSave::saveAsync(*q, qt_v8::ToQString(args[0]->ToString()),
+                     options, args[callback_index].As<Function>());
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   toBuffer( )
+//   toBuffer( QString format )
+//   toBuffer( QString format, int quality )
+// Encodes (default 'png') into a new Buffer without going through the
+// filesystem. Throws on failure
+NAN_METHOD(QImageWrap::ToBuffer) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  QByteArray format = args[0]->IsString() ?
+      qt_v8::ToQString(args[0]->ToString()).toLatin1() : QByteArray("png");
+  int quality = args[1]->IsNumber() ? args[1]->IntegerValue() : -1;
+
+  QString error;
+  QByteArray* data = ImageBuffer::encode(*q, format, quality, &error);
+  if (!data)
+    return NanThrowError(("QImage::ToBuffer: " + error).toUtf8().constData());
+
+  NanReturnValue(ImageBuffer::toBuffer(data));
+}
+
+// Supported versions:
+//   toBufferAsync( Function callback )
+//   toBufferAsync( QString format, Function callback )
+//   toBufferAsync( QString format, int quality, Function callback )
+// Calls back with (error, buffer)
+NAN_METHOD(QImageWrap::ToBufferAsync) {
+  NanScope();
+
+  QImageWrap* w = ObjectWrap::Unwrap<QImageWrap>(args.This());
+  QImage* q = w->GetWrapped();
+
+  int callback_index = args.Length() - 1;
+  if (callback_index < 0 || callback_index > 2 ||
+      !args[callback_index]->IsFunction())
+    return NanThrowTypeError("QImage::ToBufferAsync: bad arguments");
+
+  QByteArray format = callback_index > 0 && args[0]->IsString() ?
+      qt_v8::ToQString(args[0]->ToString()).toLatin1() : QByteArray("png");
+  int quality = callback_index > 1 && args[1]->IsNumber() ?
+      args[1]->IntegerValue() : -1;
+
+  ImageBuffer::encodeAsync(*q, format, quality,
+                           args[callback_index].As<Function>());
+
+  NanReturnUndefined();
+}
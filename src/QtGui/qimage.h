@@ -37,7 +37,12 @@
 class QImageWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
+  static v8::Handle<v8::Value> NewInstance(QImage q);
   QImage* GetWrapped() const { return q_; };
+  void SetWrapped(QImage q) {
+    if (q_) delete q_;
+    q_ = new QImage(q);
+  };
 
  private:
   QImageWrap(_NAN_METHOD_ARGS);
@@ -47,6 +52,25 @@ class QImageWrap : public node::ObjectWrap {
 
   // Wrapped methods
   static NAN_METHOD(IsNull);
+  static NAN_METHOD(Width);
+  static NAN_METHOD(Height);
+  static NAN_METHOD(Format);
+  static NAN_METHOD(Pixel);
+  static NAN_METHOD(SaveRaw);
+  static NAN_METHOD(LoadRaw);
+  static NAN_METHOD(ConvertToFormat);
+  static NAN_METHOD(Premultiply);
+  static NAN_METHOD(Unpremultiply);
+  static NAN_METHOD(RgbSwapped);
+  static NAN_METHOD(Fill);
+  static NAN_METHOD(Blend);
+  static NAN_METHOD(ColorMatrix);
+  static NAN_METHOD(Scaled);
+  static NAN_METHOD(ScaledAsync);
+  static NAN_METHOD(Save);
+  static NAN_METHOD(SaveAsync);
+  static NAN_METHOD(ToBuffer);
+  static NAN_METHOD(ToBufferAsync);
 
   // Wrapped object
   QImage* q_;
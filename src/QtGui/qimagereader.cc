@@ -0,0 +1,233 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <node.h>
+#include "../qt_v8.h"
+#include "../QtCore/qsize.h"
+#include "qimagereader.h"
+#include "qimage.h"
+
+using namespace v8;
+
+Persistent<Function> QImageReaderWrap::constructor;
+
+// Supported implementations:
+//   QImageReader ( )
+//   QImageReader ( QString fileName )
+//   QImageReader ( QString fileName, QString format )
+QImageReaderWrap::QImageReaderWrap(_NAN_METHOD_ARGS) : q_(NULL) {
+  if (!args[0]->IsString()) {
+    // QImageReader ( )
+    q_ = new QImageReader;
+    return;
+  }
+
+  QByteArray format;
+  if (args[1]->IsString())
+    format = qt_v8::ToQString(args[1]->ToString()).toLatin1();
+
+  // QImageReader ( QString fileName, QString format = "" )
+  q_ = new QImageReader(qt_v8::ToQString(args[0]->ToString()), format);
+}
+
+QImageReaderWrap::~QImageReaderWrap() {
+  delete q_;
+}
+
+void QImageReaderWrap::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("QImageReader"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("canRead"),
+      FunctionTemplate::New(CanRead)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("format"),
+      FunctionTemplate::New(Format)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("size"),
+      FunctionTemplate::New(Size)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("imageFormat"),
+      FunctionTemplate::New(ImageFormat)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setScaledSize"),
+      FunctionTemplate::New(SetScaledSize)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("scaledSize"),
+      FunctionTemplate::New(ScaledSize)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setClipRect"),
+      FunctionTemplate::New(SetClipRect)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setScaledClipRect"),
+      FunctionTemplate::New(SetScaledClipRect)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setQuality"),
+      FunctionTemplate::New(SetQuality)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("quality"),
+      FunctionTemplate::New(Quality)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("read"),
+      FunctionTemplate::New(Read)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("errorString"),
+      FunctionTemplate::New(ErrorString)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("QImageReader"), tpl->GetFunction());
+}
+
+NAN_METHOD(QImageReaderWrap::New) {
+  NanScope();
+
+  QImageReaderWrap* w = new QImageReaderWrap(args);
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+NAN_METHOD(QImageReaderWrap::CanRead) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  NanReturnValue(Boolean::New(q->canRead()));
+}
+
+NAN_METHOD(QImageReaderWrap::Format) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  NanReturnValue(qt_v8::FromQString(QString::fromLatin1(q->format())));
+}
+
+// Reads the size from the image header, without decoding it. Returns an
+// invalid (-1 x -1) size if the format can't tell
+NAN_METHOD(QImageReaderWrap::Size) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  NanReturnValue(QSizeWrap::NewInstance(q->size()));
+}
+
+NAN_METHOD(QImageReaderWrap::ImageFormat) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->imageFormat()));
+}
+
+// Decoders that support QImageIOHandler::ScaledSize (e.g. JPEG) downscale
+// while decoding; for others QImageReader scales after a full decode
+NAN_METHOD(QImageReaderWrap::SetScaledSize) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  q->setScaledSize(QSize(args[0]->IntegerValue(), args[1]->IntegerValue()));
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QImageReaderWrap::ScaledSize) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  NanReturnValue(QSizeWrap::NewInstance(q->scaledSize()));
+}
+
+// Supported versions:
+//   setClipRect( int x, int y, int w, int h )
+NAN_METHOD(QImageReaderWrap::SetClipRect) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  q->setClipRect(QRect(args[0]->IntegerValue(), args[1]->IntegerValue(),
+                       args[2]->IntegerValue(), args[3]->IntegerValue()));
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   setScaledClipRect( int x, int y, int w, int h )
+NAN_METHOD(QImageReaderWrap::SetScaledClipRect) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  q->setScaledClipRect(QRect(args[0]->IntegerValue(), args[1]->IntegerValue(),
+                             args[2]->IntegerValue(), args[3]->IntegerValue()));
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QImageReaderWrap::SetQuality) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  q->setQuality(args[0]->IntegerValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QImageReaderWrap::Quality) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->quality()));
+}
+
+// Returns a null QImage on failure, see errorString()
+NAN_METHOD(QImageReaderWrap::Read) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  NanReturnValue(QImageWrap::NewInstance(q->read()));
+}
+
+NAN_METHOD(QImageReaderWrap::ErrorString) {
+  NanScope();
+
+  QImageReaderWrap* w = ObjectWrap::Unwrap<QImageReaderWrap>(args.This());
+  QImageReader* q = w->GetWrapped();
+
+  NanReturnValue(qt_v8::FromQString(q->errorString()));
+}
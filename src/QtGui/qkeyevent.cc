@@ -28,12 +28,14 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <node.h>
+#include <QDateTime>
 #include "qkeyevent.h"
 #include "../qt_v8.h"
 
 using namespace v8;
 
 Persistent<Function> QKeyEventWrap::constructor;
+Persistent<ObjectTemplate> QKeyEventWrap::plainTemplate;
 
 QKeyEventWrap::QKeyEventWrap() : q_(NULL) {
   // Standalone constructor not implemented
@@ -45,6 +47,9 @@ QKeyEventWrap::~QKeyEventWrap() {
 }
 
 void QKeyEventWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QKeyEvent"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("QKeyEvent"));
@@ -71,6 +76,8 @@ NAN_METHOD(QKeyEventWrap::New) {
 Handle<Value> QKeyEventWrap::NewInstance(QKeyEvent q) {
   NanScope();
 
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
   Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
   QKeyEventWrap* w = node::ObjectWrap::Unwrap<QKeyEventWrap>(instance);
   w->SetWrapped(q);
@@ -78,6 +85,35 @@ Handle<Value> QKeyEventWrap::NewInstance(QKeyEvent q) {
   return scope.Close(instance);
 }
 
+// Every object comes from the same template with its fields already in
+// place, so they all share one shape. QKeyEvent has no timestamp in Qt 4;
+// ours is taken at delivery, in ms since the epoch like Date.now()
+Handle<Value> QKeyEventWrap::NewPlainObject(const QKeyEvent& e) {
+  NanScope();
+
+  if (plainTemplate.IsEmpty()) {
+    Local<ObjectTemplate> tpl = ObjectTemplate::New();
+    tpl->Set(String::NewSymbol("key"), Integer::New(0));
+    tpl->Set(String::NewSymbol("text"), String::New(""));
+    tpl->Set(String::NewSymbol("modifiers"), Integer::New(0));
+    tpl->Set(String::NewSymbol("autoRepeat"), Boolean::New(false));
+    tpl->Set(String::NewSymbol("count"), Integer::New(0));
+    tpl->Set(String::NewSymbol("timestamp"), Number::New(0));
+    NanAssignPersistent(ObjectTemplate, plainTemplate, tpl);
+  }
+
+  Local<Object> obj = NanPersistentToLocal(plainTemplate)->NewInstance();
+  obj->Set(String::NewSymbol("key"), Integer::New(e.key()));
+  obj->Set(String::NewSymbol("text"), qt_v8::FromQString(e.text()));
+  obj->Set(String::NewSymbol("modifiers"), Integer::New(e.modifiers()));
+  obj->Set(String::NewSymbol("autoRepeat"), Boolean::New(e.isAutoRepeat()));
+  obj->Set(String::NewSymbol("count"), Integer::New(e.count()));
+  obj->Set(String::NewSymbol("timestamp"),
+           Number::New(QDateTime::currentMSecsSinceEpoch()));
+
+  return scope.Close(obj);
+}
+
 NAN_METHOD(QKeyEventWrap::Key) {
   NanScope();
 
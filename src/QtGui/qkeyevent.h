@@ -38,6 +38,9 @@ class QKeyEventWrap : public node::ObjectWrap {
  public:
   static void Initialize(v8::Handle<v8::Object> target);
   static v8::Handle<v8::Value> NewInstance(QKeyEvent q);
+  // Plain { key, text, modifiers, autoRepeat, count, timestamp } object,
+  // filled in one go; nothing is copied to the heap
+  static v8::Handle<v8::Value> NewPlainObject(const QKeyEvent& e);
   QKeyEvent* GetWrapped() const { return q_; };
   void SetWrapped(QKeyEvent q) {
     if (q_) delete q_;
@@ -48,6 +51,7 @@ class QKeyEventWrap : public node::ObjectWrap {
   QKeyEventWrap();
   ~QKeyEventWrap();
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::ObjectTemplate> plainTemplate;
   static NAN_METHOD(New);
 
   // Wrapped methods
@@ -74,6 +74,9 @@ QMatrixWrap::~QMatrixWrap() {
 }
 
 void QMatrixWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QMatrix"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("QMatrix"));
@@ -113,6 +116,8 @@ NAN_METHOD(QMatrixWrap::New) {
 Handle<Value> QMatrixWrap::NewInstance(QMatrix q) {
   NanScope();
 
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
   Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
   QMatrixWrap* w = node::ObjectWrap::Unwrap<QMatrixWrap>(instance);
   w->SetWrapped(q);
@@ -29,6 +29,7 @@
 
 #include <node.h>
 #include "qmouseevent.h"
+#include "../qt_v8.h"
 
 using namespace v8;
 
@@ -44,6 +45,9 @@ QMouseEventWrap::~QMouseEventWrap() {
 }
 
 void QMouseEventWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QMouseEvent"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("QMouseEvent"));
@@ -72,6 +76,8 @@ NAN_METHOD(QMouseEventWrap::New) {
 Handle<Value> QMouseEventWrap::NewInstance(QMouseEvent q) {
   NanScope();
 
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
   Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
   QMouseEventWrap* w = node::ObjectWrap::Unwrap<QMouseEventWrap>(instance);
   w->SetWrapped(q);
@@ -0,0 +1,464 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <climits>
+#include <cstring>
+#include <node.h>
+#include <QTimerEvent>
+#include "../qt_v8.h"
+#include "qmovie.h"
+#include "qimage.h"
+#include "qapplication.h"
+
+using namespace v8;
+
+Persistent<Function> QMovieWrap::constructor;
+
+//
+// QMovieImpl()
+//
+
+QMovieImpl::QMovieImpl(const QString& fileName, const QByteArray& format)
+    : movie_(fileName, format), cacheSize_(16), current_(-1), delay_(0),
+      state_(NotRunning), speed_(100) {
+}
+
+QMovieImpl::~QMovieImpl() {
+}
+
+// Bounding rect of the pixels that differ between two frames, empty if
+// none do
+static QRect ChangedRect(const QImage& from, const QImage& to) {
+  if (from.size() != to.size())
+    return to.rect();
+
+  QImage a = from.convertToFormat(QImage::Format_ARGB32);
+  QImage b = to.convertToFormat(QImage::Format_ARGB32);
+
+  int width = b.width();
+  int top = -1, bottom = -1, left = width, right = -1;
+  for (int y = 0; y < b.height(); ++y) {
+    const QRgb* ra = reinterpret_cast<const QRgb*>(a.constScanLine(y));
+    const QRgb* rb = reinterpret_cast<const QRgb*>(b.constScanLine(y));
+    if (memcmp(ra, rb, width * sizeof(QRgb)) == 0)
+      continue;
+
+    if (top < 0)
+      top = y;
+    bottom = y;
+
+    int x = 0;
+    while (x < left && ra[x] == rb[x])
+      ++x;
+    left = qMin(left, x);
+
+    x = width - 1;
+    while (x > right && ra[x] == rb[x])
+      --x;
+    right = qMax(right, x);
+  }
+
+  if (top < 0)
+    return QRect();
+  return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+// Fetches a frame from the cache, or decodes it. Decoding the frame right
+// after the decoder's position is cheap; anything else makes QMovie rewind
+// and read forward
+bool QMovieImpl::frame(int number, Frame* frame) {
+  QMap<int, Frame>::const_iterator it = cache_.constFind(number);
+  if (it != cache_.constEnd()) {
+    *frame = it.value();
+    return true;
+  }
+
+  bool sequential = number > 0 && movie_.currentFrameNumber() + 1 == number;
+  QImage previous;
+  if (sequential)
+    previous = movie_.currentImage();
+
+  bool ok = sequential ?
+      movie_.jumpToNextFrame() : movie_.jumpToFrame(number);
+  if (!ok || movie_.currentFrameNumber() != number)
+    return false;
+
+  frame->image = movie_.currentImage();
+  frame->delay = movie_.nextFrameDelay();
+  if (frame->image.isNull())
+    return false;
+
+  // QMovie::frameRect() is the whole image in Qt 4.8, and QMovie keeps its
+  // QImageReader (and currentImageRect()) to itself, so the changed area
+  // comes from comparing against the previous frame, once per decode
+  frame->diffed = sequential;
+  if (sequential)
+    frame->rect = ChangedRect(previous, frame->image);
+
+  if (cacheSize_ > 0) {
+    cache_.insert(number, *frame);
+    trimCache(number);
+  }
+
+  return true;
+}
+
+// Evicts the cached frames that will be needed last, counting forward
+// (and around the loop) from next
+void QMovieImpl::trimCache(int next) {
+  int count = movie_.frameCount();
+
+  while (cache_.size() > cacheSize_) {
+    QMap<int, Frame>::iterator victim = cache_.begin();
+    int farthest = -1;
+    for (QMap<int, Frame>::iterator it = cache_.begin(); it != cache_.end();
+         ++it) {
+      int distance = count > 0 ? (it.key() - next + count) % count :
+                                 it.key() - next;
+      if (count <= 0 && distance < 0)
+        distance = INT_MAX + distance; // unknown length: already played
+      if (distance > farthest) {
+        farthest = distance;
+        victim = it;
+      }
+    }
+    cache_.erase(victim);
+  }
+}
+
+void QMovieImpl::show(int number, const Frame& frame, bool sequential) {
+  QRect changed(QPoint(0, 0), frame.image.size());
+  if (sequential && frame.diffed)
+    changed &= frame.rect;
+
+  current_ = number;
+  image_ = frame.image;
+  delay_ = frame.delay;
+
+  for (int i = 0; i < views_.size(); ++i)
+    views_[i].first->update(changed.translated(views_[i].second));
+}
+
+void QMovieImpl::schedule() {
+  // Browsers treat 0 (and tiny) GIF delays as 100ms; so do we
+  int delay = delay_ > 10 ? delay_ : 100;
+  timer_.start(qMax(1, delay * 100 / speed_), this);
+}
+
+void QMovieImpl::timerEvent(QTimerEvent* e) {
+  if (e->timerId() != timer_.timerId()) {
+    QObject::timerEvent(e);
+    return;
+  }
+
+  int count = movie_.frameCount();
+  int next = current_ + 1;
+  if (count > 0 && next >= count)
+    next = 0;
+
+  Frame f;
+  if (!frame(next, &f)) {
+    // Past the end of a movie of unknown length: loop
+    next = 0;
+    if (!frame(next, &f)) {
+      stop();
+      return;
+    }
+  }
+
+  show(next, f, next == current_ + 1);
+  schedule();
+}
+
+bool QMovieImpl::jumpToFrame(int number) {
+  Frame f;
+  if (!frame(number, &f))
+    return false;
+
+  show(number, f, false);
+  if (state_ == Running)
+    schedule();
+  return true;
+}
+
+void QMovieImpl::start() {
+  if (state_ == Running)
+    return;
+
+  if (state_ == NotRunning || current_ < 0) {
+    if (!jumpToFrame(0))
+      return;
+  }
+
+  state_ = Running;
+  schedule();
+}
+
+void QMovieImpl::stop() {
+  timer_.stop();
+  state_ = NotRunning;
+}
+
+void QMovieImpl::setPaused(bool paused) {
+  if (paused && state_ == Running) {
+    timer_.stop();
+    state_ = Paused;
+  } else if (!paused && state_ == Paused) {
+    state_ = Running;
+    schedule();
+  }
+}
+
+void QMovieImpl::setCacheSize(int frames) {
+  cacheSize_ = qMax(0, frames);
+  trimCache(current_ + 1);
+}
+
+void QMovieImpl::addView(QWidget* widget, const QPoint& pos) {
+  removeView(widget);
+  views_.append(qMakePair(widget, pos));
+  widget->update(QRect(pos, image_.size()));
+}
+
+void QMovieImpl::removeView(QWidget* widget) {
+  for (int i = views_.size() - 1; i >= 0; --i) {
+    if (views_[i].first == widget) {
+      widget->update(QRect(views_[i].second, image_.size()));
+      views_.removeAt(i);
+    }
+  }
+}
+
+//
+// QMovieWrap()
+//
+
+// Supported implementations:
+//   QMovie ( QString fileName )
+//   QMovie ( QString fileName, QString format )
+QMovieWrap::QMovieWrap(_NAN_METHOD_ARGS) : q_(NULL) {
+  QByteArray format;
+  if (args[1]->IsString())
+    format = qt_v8::ToQString(args[1]->ToString()).toLatin1();
+
+  q_ = new QMovieImpl(qt_v8::ToQString(args[0]->ToString()), format);
+}
+
+QMovieWrap::~QMovieWrap() {
+  delete q_;
+}
+
+void QMovieWrap::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("QMovie"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("isValid"),
+      FunctionTemplate::New(IsValid)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("frameCount"),
+      FunctionTemplate::New(FrameCount)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("currentFrameNumber"),
+      FunctionTemplate::New(CurrentFrameNumber)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("currentImage"),
+      FunctionTemplate::New(CurrentImage)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("jumpToFrame"),
+      FunctionTemplate::New(JumpToFrame)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("start"),
+      FunctionTemplate::New(Start)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("stop"),
+      FunctionTemplate::New(Stop)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setPaused"),
+      FunctionTemplate::New(SetPaused)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("state"),
+      FunctionTemplate::New(State)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setSpeed"),
+      FunctionTemplate::New(SetSpeed)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("speed"),
+      FunctionTemplate::New(Speed)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setCacheSize"),
+      FunctionTemplate::New(SetCacheSize)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("cacheSize"),
+      FunctionTemplate::New(CacheSize)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("QMovie"), tpl->GetFunction());
+}
+
+NAN_METHOD(QMovieWrap::New) {
+  NanScope();
+
+  if (!QApplicationWrap::HasGui())
+    return NanThrowError("QMovie::QMovie: application was created without gui");
+
+  if (!args[0]->IsString())
+    return NanThrowTypeError("QMovie::QMovie: bad arguments");
+
+  QMovieWrap* w = new QMovieWrap(args);
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+NAN_METHOD(QMovieWrap::IsValid) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  NanReturnValue(Boolean::New(q->isValid()));
+}
+
+// 0 if the format can't tell without decoding everything
+NAN_METHOD(QMovieWrap::FrameCount) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->frameCount()));
+}
+
+// -1 until the first frame has been shown
+NAN_METHOD(QMovieWrap::CurrentFrameNumber) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->currentFrameNumber()));
+}
+
+NAN_METHOD(QMovieWrap::CurrentImage) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  NanReturnValue(QImageWrap::NewInstance(q->currentImage()));
+}
+
+NAN_METHOD(QMovieWrap::JumpToFrame) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  NanReturnValue(Boolean::New(q->jumpToFrame(args[0]->IntegerValue())));
+}
+
+// QUIRK:
+// Frames advance from Qt's event loop, so the application must keep
+// calling processEvents()
+NAN_METHOD(QMovieWrap::Start) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  q->start();
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QMovieWrap::Stop) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  q->stop();
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QMovieWrap::SetPaused) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  q->setPaused(args[0]->BooleanValue());
+
+  NanReturnUndefined();
+}
+
+// QMovie::MovieState: 0 NotRunning, 1 Paused, 2 Running
+NAN_METHOD(QMovieWrap::State) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->state()));
+}
+
+// Playback speed in percent, 100 being the movie's own frame delays
+NAN_METHOD(QMovieWrap::SetSpeed) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  q->setSpeed(args[0]->IntegerValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QMovieWrap::Speed) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->speed()));
+}
+
+// Number of decoded frames kept around (default 16). Movies no longer
+// than this are decoded once and then played from memory
+NAN_METHOD(QMovieWrap::SetCacheSize) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  q->setCacheSize(args[0]->IntegerValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QMovieWrap::CacheSize) {
+  NanScope();
+
+  QMovieWrap* w = ObjectWrap::Unwrap<QMovieWrap>(args.This());
+  QMovieImpl* q = w->GetWrapped();
+
+  NanReturnValue(Integer::New(q->cacheSize()));
+}
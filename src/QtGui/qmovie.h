@@ -0,0 +1,134 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef QMOVIEWRAP_H
+#define QMOVIEWRAP_H
+
+#include <node.h>
+#include <QBasicTimer>
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QMovie>
+#include <QPair>
+#include <QWidget>
+#include <nan.h>
+
+//
+// QMovieImpl()
+// Plays a QMovie without signals/slots: frames are pulled from the movie
+// on our own timer (timerEvent() needs no moc), kept in a window of
+// decoded frames, and each attached widget is asked to repaint only the
+// region that changed between frames
+//
+class QMovieImpl : public QObject {
+ public:
+  enum { NotRunning = 0, Paused = 1, Running = 2 };
+
+  QMovieImpl(const QString& fileName, const QByteArray& format);
+  ~QMovieImpl();
+
+  bool isValid() const { return movie_.isValid(); };
+  int frameCount() const { return movie_.frameCount(); };
+  int currentFrameNumber() const { return current_; };
+  const QImage& currentImage() const { return image_; };
+  int state() const { return state_; };
+
+  bool jumpToFrame(int frame);
+  void start();
+  void stop();
+  void setPaused(bool paused);
+  void setSpeed(int percent) { speed_ = qMax(1, percent); };
+  int speed() const { return speed_; };
+  void setCacheSize(int frames);
+  int cacheSize() const { return cacheSize_; };
+
+  // Widgets showing the movie with its top left at pos
+  void addView(QWidget* widget, const QPoint& pos);
+  void removeView(QWidget* widget);
+
+ protected:
+  void timerEvent(QTimerEvent* e);
+
+ private:
+  struct Frame {
+    QImage image;
+    QRect rect;   // area that differs from the previous frame, if diffed
+    bool diffed;  // false when decoded out of order, or for frame 0
+    int delay;
+  };
+
+  bool frame(int number, Frame* frame);
+  void show(int number, const Frame& frame, bool sequential);
+  void schedule();
+  void trimCache(int next);
+
+  QMovie movie_;
+  QMap<int, Frame> cache_;
+  int cacheSize_;
+  int current_;
+  int delay_;
+  int state_;
+  int speed_;
+  QImage image_;
+  QBasicTimer timer_;
+  QList<QPair<QWidget*, QPoint> > views_;
+};
+
+class QMovieWrap : public node::ObjectWrap {
+ public:
+  static void Initialize(v8::Handle<v8::Object> target);
+  QMovieImpl* GetWrapped() const { return q_; };
+
+ private:
+  QMovieWrap(_NAN_METHOD_ARGS);
+  ~QMovieWrap();
+  static v8::Persistent<v8::Function> constructor;
+  static NAN_METHOD(New);
+
+  // Wrapped methods
+  static NAN_METHOD(IsValid);
+  static NAN_METHOD(FrameCount);
+  static NAN_METHOD(CurrentFrameNumber);
+  static NAN_METHOD(CurrentImage);
+  static NAN_METHOD(JumpToFrame);
+  static NAN_METHOD(Start);
+  static NAN_METHOD(Stop);
+  static NAN_METHOD(SetPaused);
+  static NAN_METHOD(State);
+  static NAN_METHOD(SetSpeed);
+  static NAN_METHOD(Speed);
+  static NAN_METHOD(SetCacheSize);
+  static NAN_METHOD(CacheSize);
+
+  // Wrapped object
+  QMovieImpl* q_;
+};
+
+#endif
@@ -39,6 +39,8 @@
 #include "qpainterpath.h"
 #include "qfont.h"
 #include "qmatrix.h"
+#include "qpicture.h"
+#include "../Extras/imagepyramid.h"
 
 using namespace v8;
 
@@ -126,9 +128,24 @@ NAN_METHOD(QPainterWrap::Begin) {
     // QWidget
     QWidgetWrap* widget_wrap = ObjectWrap::Unwrap<QWidgetWrap>(
         args[0]->ToObject());
-    QWidget* widget = widget_wrap->GetWrapped();
+    QWidgetImpl* widget = widget_wrap->GetWrapped();
 
-    NanReturnValue(Boolean::New( q->begin(widget) ));
+    // Goes to the frame capture canvas during captured paints
+    NanReturnValue(Boolean::New( widget->beginPaint(q) ));
+  } else if (constructor_name == "QImage") {
+    // QImage
+    QImageWrap* image_wrap = ObjectWrap::Unwrap<QImageWrap>(
+        args[0]->ToObject());
+    QImage* image = image_wrap->GetWrapped();
+
+    NanReturnValue(Boolean::New( q->begin(image) ));
+  } else if (constructor_name == "QPicture") {
+    // QPicture
+    QPictureWrap* picture_wrap = ObjectWrap::Unwrap<QPictureWrap>(
+        args[0]->ToObject());
+    QPicture* picture = picture_wrap->GetWrapped();
+
+    NanReturnValue(Boolean::New( q->begin(picture) ));
   }
 
   // Unknown argument type
@@ -359,6 +376,7 @@ NAN_METHOD(QPainterWrap::DrawPixmap) {
 
 // Supported versions:
 //   drawImage( int x, int y, QImage image )
+//   drawImage( int x, int y, ImagePyramid pyramid )
 NAN_METHOD(QPainterWrap::DrawImage) {
   NanScope();
 
@@ -371,6 +389,17 @@ NAN_METHOD(QPainterWrap::DrawImage) {
         qt_v8::ToQString(args[2]->ToObject()->GetConstructorName());
   }
 
+  if (arg2_constructor == "ImagePyramid") {
+    // drawImage( int x, int y, ImagePyramid pyramid )
+    // Draws at the source image's size, from the level matching the
+    // current world transform
+    ImagePyramid* pyramid = ObjectWrap::Unwrap<ImagePyramid>(
+        args[2]->ToObject());
+    pyramid->draw(q, args[0]->IntegerValue(), args[1]->IntegerValue());
+
+    NanReturnUndefined();
+  }
+
   if (arg2_constructor != "QImage" ) {
     return NanThrowTypeError("QPainterWrap::DrawImage: image argument not recognized");
   }
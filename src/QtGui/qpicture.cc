@@ -0,0 +1,298 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <climits>
+#include <node.h>
+#include <QList>
+#include <QRect>
+#include <QPainter>
+#include <QPaintEngine>
+#include <QtConcurrentMap>
+#include "../qt_v8.h"
+#include "qpicture.h"
+#include "qpainter.h"
+#include "qimage.h"
+
+using namespace v8;
+
+Persistent<Function> QPictureWrap::constructor;
+
+//
+// PictureTileRenderer
+// Plays back a recorded picture into one tile of a 32-bit target image.
+// Tiles are views onto the target's own pixels, so nothing needs stitching
+// afterwards. QPicture::play() seeks within the picture's (shared) buffer,
+// so every tile replays from a private deep copy of the data
+//
+class PictureTileRenderer {
+ public:
+  typedef void result_type;
+
+  PictureTileRenderer(const QByteArray& data, uchar* bits, int bytesPerLine,
+                      QImage::Format format)
+      : data_(data), bits_(bits), bytesPerLine_(bytesPerLine),
+        format_(format) {}
+
+  void operator()(const QRect& tile) const {
+    QPicture picture;
+    picture.setData(data_.constData(), data_.size());
+
+    QImage view(bits_ + tile.y() * bytesPerLine_ + tile.x() * 4,
+                tile.width(), tile.height(), bytesPerLine_, format_);
+
+    QPainter painter(&view);
+    painter.setClipRect(0, 0, tile.width(), tile.height());
+    painter.translate(-tile.x(), -tile.y());
+    picture.play(&painter);
+  }
+
+ private:
+  QByteArray data_;
+  uchar* bits_;
+  int bytesPerLine_;
+  QImage::Format format_;
+};
+
+//
+// PixmapProbe
+// A paint device that draws nothing and only notes whether a picture played
+// into it uses pixmaps (drawn, tiled, or as a brush or pen texture). Playing
+// a picture back rebuilds those pixmaps, which Qt 4 only allows on the GUI
+// thread
+//
+class PixmapProbe : public QPaintDevice, public QPaintEngine {
+ public:
+  PixmapProbe() : QPaintEngine(AllFeatures), found_(false) {}
+
+  bool found() const { return found_; }
+
+  // QPaintDevice
+  QPaintEngine* paintEngine() const {
+    return const_cast<PixmapProbe*>(this);
+  }
+
+  // QPaintEngine
+  bool begin(QPaintDevice*) { return true; }
+  bool end() { return true; }
+  Type type() const { return User; }
+
+  void updateState(const QPaintEngineState& state) {
+    if (state.state() & DirtyBrush &&
+        state.brush().style() == Qt::TexturePattern)
+      found_ = true;
+    if (state.state() & DirtyPen &&
+        state.pen().brush().style() == Qt::TexturePattern)
+      found_ = true;
+  }
+
+  void drawPixmap(const QRectF&, const QPixmap&, const QRectF&) {
+    found_ = true;
+  }
+  void drawTiledPixmap(const QRectF&, const QPixmap&, const QPointF&) {
+    found_ = true;
+  }
+
+  // The defaults of these go through pixmaps or warn
+  void drawImage(const QRectF&, const QImage&, const QRectF&,
+                 Qt::ImageConversionFlags) {}
+  void drawPath(const QPainterPath&) {}
+  void drawPolygon(const QPointF*, int, PolygonDrawMode) {}
+  void drawTextItem(const QPointF&, const QTextItem&) {}
+
+ protected:
+  int metric(PaintDeviceMetric metric) const {
+    switch (metric) {
+      case PdmWidth:
+      case PdmHeight:
+      case PdmWidthMM:
+      case PdmHeightMM:
+        return INT_MAX / 2;
+      case PdmNumColors:
+        return INT_MAX;
+      case PdmDepth:
+        return 32;
+      default:
+        return 72;
+    }
+  }
+
+ private:
+  bool found_;
+};
+
+QPictureWrap::QPictureWrap() : q_(NULL) {
+  q_ = new QPicture;
+}
+
+QPictureWrap::~QPictureWrap() {
+  delete q_;
+}
+
+void QPictureWrap::Initialize(Handle<Object> target) {
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
+  tpl->SetClassName(String::NewSymbol("QPicture"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototype
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("isNull"),
+      FunctionTemplate::New(IsNull)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("size"),
+      FunctionTemplate::New(Size)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("play"),
+      FunctionTemplate::New(Play)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("renderTiled"),
+      FunctionTemplate::New(RenderTiled)->GetFunction());
+
+  NanAssignPersistent(Function, constructor, tpl->GetFunction());
+  target->Set(String::NewSymbol("QPicture"), tpl->GetFunction());
+}
+
+NAN_METHOD(QPictureWrap::New) {
+  NanScope();
+
+  QPictureWrap* w = new QPictureWrap();
+  w->Wrap(args.This());
+
+  NanReturnValue(args.This());
+}
+
+NAN_METHOD(QPictureWrap::IsNull) {
+  NanScope();
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  NanReturnValue(Boolean::New(q->isNull()));
+}
+
+// QUIRK:
+// Returns the size of the recorded data in bytes, as in Qt
+NAN_METHOD(QPictureWrap::Size) {
+  NanScope();
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  NanReturnValue(Integer::NewFromUnsigned(q->size()));
+}
+
+// Supported versions:
+//   play( QPainter painter )
+NAN_METHOD(QPictureWrap::Play) {
+  NanScope();
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  QString arg0_constructor;
+  if (args[0]->IsObject()) {
+    arg0_constructor =
+        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  }
+
+  if (arg0_constructor != "QPainter")
+    return NanThrowTypeError("QPictureWrap::Play: bad argument");
+
+  // Unwrap QPainter
+  QPainterWrap* painter_wrap = ObjectWrap::Unwrap<QPainterWrap>(
+      args[0]->ToObject());
+  QPainter* painter = painter_wrap->GetWrapped();
+
+  NanReturnValue(Boolean::New(q->play(painter)));
+}
+
+//
+// RenderTiled()
+// Replays the picture into a 32-bit QImage, split into tiles that are
+// rendered concurrently on QThreadPool::globalInstance(). Blocks until
+// every tile is done. The painter used to record the picture must have been
+// end()'ed first.
+//
+// QUIRK:
+// Tiles replay on worker threads, where Qt 4 can't create QPixmaps (the
+// native X11 graphics system crashes). Pictures that use pixmaps are
+// rejected; record drawImage() instead
+//
+// Supported versions:
+//   renderTiled( QImage image )
+//   renderTiled( QImage image, int tileSize )
+NAN_METHOD(QPictureWrap::RenderTiled) {
+  NanScope();
+
+  QPictureWrap* w = ObjectWrap::Unwrap<QPictureWrap>(args.This());
+  QPicture* q = w->GetWrapped();
+
+  QString arg0_constructor;
+  if (args[0]->IsObject()) {
+    arg0_constructor =
+        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  }
+
+  if (arg0_constructor != "QImage")
+    return NanThrowTypeError("QPictureWrap::RenderTiled: bad argument");
+
+  // Unwrap QImage
+  QImageWrap* image_wrap = ObjectWrap::Unwrap<QImageWrap>(
+      args[0]->ToObject());
+  QImage* image = image_wrap->GetWrapped();
+
+  if (image->isNull() || image->depth() != 32) {
+    return NanThrowTypeError(
+        "QPictureWrap::RenderTiled: image must be a non-null 32-bit image");
+  }
+
+  int tileSize = args[1]->IsNumber() ? args[1]->IntegerValue() : 512;
+  if (tileSize <= 0)
+    return NanThrowRangeError("QPictureWrap::RenderTiled: bad tile size");
+
+  PixmapProbe probe;
+  QPainter painter(&probe);
+  q->play(&painter);
+  painter.end();
+  if (probe.found()) {
+    return NanThrowError(
+        "QPictureWrap::RenderTiled: picture uses pixmaps; draw images instead");
+  }
+
+  QList<QRect> tiles;
+  for (int y = 0; y < image->height(); y += tileSize) {
+    for (int x = 0; x < image->width(); x += tileSize) {
+      tiles.append(QRect(x, y, tileSize, tileSize) & image->rect());
+    }
+  }
+
+  // bits() detaches the image here, on the main thread, before any tile
+  // writes into it
+  QtConcurrent::blockingMap(tiles, PictureTileRenderer(
+      QByteArray(q->data(), q->size()), image->bits(), image->bytesPerLine(),
+      image->format()));
+
+  NanReturnUndefined();
+}
@@ -30,7 +30,10 @@
 #include <node.h>
 #include "../qt_v8.h"
 #include "qpixmap.h"
+#include "qapplication.h"
 #include "qcolor.h"
+#include "../Extras/imagebuffer.h"
+#include "../Extras/pngsave.h"
 
 using namespace v8;
 
@@ -44,6 +47,9 @@ QPixmapWrap::~QPixmapWrap() {
 }
 
 void QPixmapWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QPixmap"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("QPixmap"));
@@ -56,6 +62,12 @@ void QPixmapWrap::Initialize(Handle<Object> target) {
       FunctionTemplate::New(Height)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("save"),
       FunctionTemplate::New(Save)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("saveAsync"),
+      FunctionTemplate::New(SaveAsync)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("toBuffer"),
+      FunctionTemplate::New(ToBuffer)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("toBufferAsync"),
+      FunctionTemplate::New(ToBufferAsync)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("fill"),
       FunctionTemplate::New(Fill)->GetFunction());
 
@@ -66,6 +78,9 @@ void QPixmapWrap::Initialize(Handle<Object> target) {
 NAN_METHOD(QPixmapWrap::New) {
   NanScope();
 
+  if (!QApplicationWrap::HasGui())
+    return NanThrowError("QPixmap::QPixmap: application was created without gui");
+
   QPixmapWrap* w = new QPixmapWrap(args[0]->IntegerValue(),
       args[1]->IntegerValue());
   w->Wrap(args.This());
@@ -76,6 +91,8 @@ NAN_METHOD(QPixmapWrap::New) {
 Handle<Value> QPixmapWrap::NewInstance(QPixmap q) {
   NanScope();
 
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
   Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
   QPixmapWrap* w = node::ObjectWrap::Unwrap<QPixmapWrap>(instance);
   w->SetWrapped(q);
@@ -101,6 +118,12 @@ NAN_METHOD(QPixmapWrap::Height) {
   NanReturnValue(Number::New(q->height()));
 }
 
+// Supported versions:
+//   save( QString file )
+//   save( QString file, Object pngOptions )
+// With options the file is always written as PNG by Extras/pngencoder:
+// { compression: 0-9, filter: 'none'|'sub'|'up'|'average'|'paeth'|
+// 'adaptive', threads: n }. Returns false on failure
 NAN_METHOD(QPixmapWrap::Save) {
   NanScope();
 
@@ -109,7 +132,93 @@ NAN_METHOD(QPixmapWrap::Save) {
 
   QString file(qt_v8::ToQString(args[0]->ToString()));
 
-  NanReturnValue(Boolean::New( q->save(file) ));
+  if (!args[1]->IsObject())
+    NanReturnValue(Boolean::New( q->save(file) ));
+
+  PngSave::Options options;
+  QString error;
+  if (!PngSave::parseOptions(args[1], &options, &error))
+    return NanThrowTypeError(("QPixmap::Save: " + error).toUtf8().constData());
+
+  NanReturnValue(Boolean::New(
+      PngSave::save(q->toImage(), file, options, &error)));
+}
+
+// Supported versions:
+//   saveAsync( QString file, Function callback )
+//   saveAsync( QString file, Object pngOptions, Function callback )
+// Always PNG; options as for save(). Calls back with (error)
+NAN_METHOD(QPixmapWrap::SaveAsync) {
+  NanScope();
+
+  QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  QPixmap* q = w->GetWrapped();
+
+  int callback_index = args[1]->IsFunction() ? 1 : 2;
+  if (!args[0]->IsString() || !args[callback_index]->IsFunction())
+    return NanThrowTypeError("QPixmap::SaveAsync: bad arguments");
+
+  PngSave::Options options;
+  QString error;
+  if (!PngSave::parseOptions(callback_index == 2 ? args[1] :
+                             Handle<Value>(Undefined()), &options, &error))
+    return NanThrowTypeError(("QPixmap::SaveAsync: " + error).toUtf8().constData());
+
+  PngSave::saveAsync(q->toImage(), qt_v8::ToQString(args[0]->ToString()),
+                     options, args[callback_index].As<Function>());
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   toBuffer( )
+//   toBuffer( QString format )
+//   toBuffer( QString format, int quality )
+// Encodes (default 'png') into a new Buffer without going through the
+// filesystem. Throws on failure
+NAN_METHOD(QPixmapWrap::ToBuffer) {
+  NanScope();
+
+  QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  QPixmap* q = w->GetWrapped();
+
+  QByteArray format = args[0]->IsString() ?
+      qt_v8::ToQString(args[0]->ToString()).toLatin1() : QByteArray("png");
+  int quality = args[1]->IsNumber() ? args[1]->IntegerValue() : -1;
+
+  QString error;
+  QByteArray* data = ImageBuffer::encode(q->toImage(), format, quality, &error);
+  if (!data)
+    return NanThrowError(("QPixmap::ToBuffer: " + error).toUtf8().constData());
+
+  NanReturnValue(ImageBuffer::toBuffer(data));
+}
+
+// Supported versions:
+//   toBufferAsync( Function callback )
+//   toBufferAsync( QString format, Function callback )
+//   toBufferAsync( QString format, int quality, Function callback )
+// Calls back with (error, buffer)
+NAN_METHOD(QPixmapWrap::ToBufferAsync) {
+  NanScope();
+
+  QPixmapWrap* w = ObjectWrap::Unwrap<QPixmapWrap>(args.This());
+  QPixmap* q = w->GetWrapped();
+
+  int callback_index = args.Length() - 1;
+  if (callback_index < 0 || callback_index > 2 ||
+      !args[callback_index]->IsFunction())
+    return NanThrowTypeError("QPixmap::ToBufferAsync: bad arguments");
+
+  QByteArray format = callback_index > 0 && args[0]->IsString() ?
+      qt_v8::ToQString(args[0]->ToString()).toLatin1() : QByteArray("png");
+  int quality = callback_index > 1 && args[1]->IsNumber() ?
+      args[1]->IntegerValue() : -1;
+
+  ImageBuffer::encodeAsync(q->toImage(), format, quality,
+                           args[callback_index].As<Function>());
+
+  NanReturnUndefined();
 }
 
 // Supports:
@@ -54,6 +54,9 @@ class QPixmapWrap : public node::ObjectWrap {
   static NAN_METHOD(Width);
   static NAN_METHOD(Height);
   static NAN_METHOD(Save);
+  static NAN_METHOD(SaveAsync);
+  static NAN_METHOD(ToBuffer);
+  static NAN_METHOD(ToBufferAsync);
   static NAN_METHOD(Fill);
 
   // Wrapped object
@@ -0,0 +1,74 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <node.h>
+#include <QPixmapCache>
+#include "qpixmapcache.h"
+
+using namespace v8;
+
+void QPixmapCacheWrap::Initialize(Handle<Object> target) {
+  Local<Object> cache = Object::New();
+
+  cache->Set(String::NewSymbol("cacheLimit"),
+      FunctionTemplate::New(CacheLimit)->GetFunction());
+  cache->Set(String::NewSymbol("setCacheLimit"),
+      FunctionTemplate::New(SetCacheLimit)->GetFunction());
+  cache->Set(String::NewSymbol("clear"),
+      FunctionTemplate::New(Clear)->GetFunction());
+
+  target->Set(String::NewSymbol("QPixmapCache"), cache);
+}
+
+// In kilobytes
+NAN_METHOD(QPixmapCacheWrap::CacheLimit) {
+  NanScope();
+
+  NanReturnValue(Integer::New(QPixmapCache::cacheLimit()));
+}
+
+// In kilobytes. Lowering the limit evicts least recently used pixmaps
+NAN_METHOD(QPixmapCacheWrap::SetCacheLimit) {
+  NanScope();
+
+  if (!args[0]->IsNumber() || args[0]->Int32Value() < 0)
+    return NanThrowTypeError("QPixmapCache::setCacheLimit: bad arguments");
+
+  QPixmapCache::setCacheLimit(args[0]->Int32Value());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QPixmapCacheWrap::Clear) {
+  NanScope();
+
+  QPixmapCache::clear();
+
+  NanReturnUndefined();
+}
@@ -32,6 +32,7 @@
 #include "../qt_v8.h"
 #include "../QtCore/qsize.h"
 #include "qscrollarea.h"
+#include "qapplication.h"
 #include "qwidget.h"
 #include "qscrollbar.h"
 
@@ -128,6 +129,9 @@ void QScrollAreaWrap::Initialize(Handle<Object> target) {
 NAN_METHOD(QScrollAreaWrap::New) {
   NanScope();
 
+  if (!QApplicationWrap::HasGui())
+    return NanThrowError("QScrollArea::QScrollArea: application was created without gui");
+
   QScrollAreaWrap* w = new QScrollAreaWrap(args);
   w->Wrap(args.This());
 
@@ -29,6 +29,7 @@
 
 #include <node.h>
 #include "qscrollbar.h"
+#include "../qt_v8.h"
 
 using namespace v8;
 
@@ -43,6 +44,9 @@ QScrollBarWrap::~QScrollBarWrap() {
 }
 
 void QScrollBarWrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "QScrollBar"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("QScrollBar"));
@@ -70,6 +74,8 @@ NAN_METHOD(QScrollBarWrap::New) {
 Handle<Value> QScrollBarWrap::NewInstance(QScrollBar *q) {
   NanScope();
 
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
   Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
   QScrollBarWrap* w = node::ObjectWrap::Unwrap<QScrollBarWrap>(instance);
   w->SetWrapped(q);
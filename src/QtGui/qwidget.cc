@@ -28,138 +28,683 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <node.h>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QBasicTimer>
+#include <QPointer>
 #include "../qt_v8.h"
 #include "../QtCore/qsize.h"
 #include "qwidget.h"
+#include "qapplication.h"
 #include "qmouseevent.h"
 #include "qkeyevent.h"
+#include "qpixmap.h"
+#include "qimage.h"
+#include "qmovie.h"
+#include "../Extras/framecapture.h"
 
 using namespace v8;
 
 Persistent<Function> QWidgetWrap::constructor;
+QList<QWidgetImpl*> QWidgetImpl::inputPending_;
+int QWidgetImpl::offscreen_ = 0;
 
 //
 // QWidgetImpl()
 //
 
-QWidgetImpl::QWidgetImpl(QWidgetImpl* parent) : QWidget(parent) {
-  // Initialize callbacks as boolean values so we can test if the callback
-  // has been set via ->IsFunction() below
-  NanAssignPersistent(Boolean, paintEventCallback_, Boolean::New(false));
-  NanAssignPersistent(Boolean, mousePressCallback_, Boolean::New(false));
-  NanAssignPersistent(Boolean, mouseReleaseCallback_, Boolean::New(false));
-  NanAssignPersistent(Boolean, mouseMoveCallback_, Boolean::New(false));
-  NanAssignPersistent(Boolean, keyPressCallback_, Boolean::New(false));
-  NanAssignPersistent(Boolean, keyReleaseCallback_, Boolean::New(false));
+QWidgetImpl::QWidgetImpl(QWidgetImpl* parent)
+    : QWidget(parent), paintingLayers_(false), capture_(NULL),
+      paintCanvas_(NULL), input_(NULL), inputCount_(0) {
+  memset(subscribed_, 0, sizeof(subscribed_));
+  memset(plain_, 0, sizeof(plain_));
+  memset(batched_, 0, sizeof(batched_));
 }
 
 QWidgetImpl::~QWidgetImpl() {
-  NanDispose(paintEventCallback_);
-  NanDispose(mousePressCallback_);
-  NanDispose(mouseReleaseCallback_);
-  NanDispose(mouseMoveCallback_);
-  NanDispose(keyPressCallback_);
-  NanDispose(keyReleaseCallback_);
+  while (!handlers_.isEmpty())
+    off(handlers_.begin().key());
+
+  clearInputEvents();
+  if (!inputRecords_.IsEmpty()) {
+    // Scripts may still hold the records object
+    NanScope();
+    Local<Object> records = NanPersistentToLocal(inputRecords_);
+    records->SetIndexedPropertiesToExternalArrayData(
+        NULL, kExternalDoubleArray, 0);
+    NanDispose(inputRecords_);
+  }
+  delete[] input_;
+
+  while (!layers_.isEmpty())
+    removeLayer(layers_.first());
+
+  while (!movies_.isEmpty())
+    removeMovie(movies_.first()->movie);
+
+  if (capture_)
+    capture_->detach();
 }
 
-void QWidgetImpl::paintEvent(QPaintEvent* e) {
-  NanScope();
+QWidgetLayer* QWidgetImpl::layer(const QString& name) const {
+  for (int i = 0; i < layers_.size(); ++i) {
+    if (layers_[i]->name == name)
+      return layers_[i];
+  }
+  return NULL;
+}
 
-  if (!NanPersistentToLocal(paintEventCallback_)->IsFunction())
+// Declares a new layer, or redefines an existing one. Only the affected
+// area is scheduled for repaint
+void QWidgetImpl::setLayer(const QString& name, const QRect& rect,
+                           int version, Handle<Function> callback) {
+  QWidgetLayer* l = layer(name);
+
+  if (!l) {
+    l = new QWidgetLayer;
+    l->name = name;
+    l->cachedVersion = version - 1;
+    l->removed = false;
+    layers_.append(l);
+  } else {
+    NanDispose(l->paintCallback);
+    update(l->rect);
+    if (l->rect.size() != rect.size())
+      l->cachedVersion = version - 1;
+  }
+
+  l->rect = rect;
+  l->version = version;
+  NanAssignPersistent(Function, l->paintCallback, callback);
+
+  update(rect);
+}
+
+void QWidgetImpl::setLayerVersion(QWidgetLayer* layer, int version) {
+  if (layer->version == version)
     return;
 
-  const unsigned argc = 0;
-  Handle<Value> argv[1] = {};
-  Handle<Function> cb = NanPersistentToLocal(Persistent<Function>::Cast(paintEventCallback_));
+  layer->version = version;
+  update(layer->rect);
+}
 
-  cb->Call(Context::GetCurrent()->Global(), argc, argv);
+void QWidgetImpl::removeLayer(QWidgetLayer* layer) {
+  layers_.removeOne(layer);
+  update(layer->rect);
+
+  // Layer callbacks may remove layers, including their own
+  if (paintingLayers_) {
+    layer->removed = true;
+    removedLayers_.append(layer);
+    return;
+  }
+
+  deleteLayer(layer);
 }
 
-void QWidgetImpl::mousePressEvent(QMouseEvent* e) {
-  e->ignore(); // ensures event bubbles up
+void QWidgetImpl::deleteLayer(QWidgetLayer* layer) {
+  QPixmapCache::remove(layer->key);
+  NanDispose(layer->paintCallback);
+  delete layer;
+}
+
+// Blits every exposed layer, calling back into JS only for layers whose
+// cached pixmap is stale or was evicted from QPixmapCache
+void QWidgetImpl::paintLayers(const QRect& exposed) {
+  QPainter painter;
+  beginPaint(&painter);
+
+  // Callbacks may change layers_; removed layers stay allocated until the
+  // loop is done
+  paintingLayers_ = true;
+  QList<QWidgetLayer*> layers = layers_;
+
+  for (int i = 0; i < layers.size(); ++i) {
+    QWidgetLayer* l = layers[i];
+    if (l->removed || !l->rect.intersects(exposed))
+      continue;
+
+    QPixmap pixmap;
+    if (l->cachedVersion != l->version ||
+        !QPixmapCache::find(l->key, &pixmap)) {
+      // The callback is free to begin() its own painter on the layer pixmap,
+      // so ours must not be active on the widget at the same time
+      painter.end();
+      pixmap = renderLayer(l);
+      beginPaint(&painter);
+      if (l->removed)
+        continue;
+    }
+
+    painter.drawPixmap(l->rect.topLeft(), pixmap);
+  }
 
+  paintingLayers_ = false;
+  while (!removedLayers_.isEmpty())
+    deleteLayer(removedLayers_.takeFirst());
+}
+
+QPixmap QWidgetImpl::renderLayer(QWidgetLayer* layer) {
   NanScope();
 
-  if (!NanPersistentToLocal(mousePressCallback_)->IsFunction())
-    return;
+  QSize size = layer->rect.size();
+  int version = layer->version;
+
+  QPixmap blank(size);
+  blank.fill(Qt::transparent);
+
+  Handle<Value> pixmap_obj = QPixmapWrap::NewInstance(blank);
+  blank = QPixmap(); // leave the wrapper as sole owner so painting won't detach
 
   const unsigned argc = 1;
   Handle<Value> argv[argc] = {
-    QMouseEventWrap::NewInstance(*e)
+    pixmap_obj
   };
-  Handle<Function> cb = NanPersistentToLocal(Persistent<Function>::Cast(mousePressCallback_));
+  Handle<Function> cb = NanPersistentToLocal(layer->paintCallback);
 
   cb->Call(Context::GetCurrent()->Global(), argc, argv);
+
+  QPixmapWrap* pixmap_wrap = node::ObjectWrap::Unwrap<QPixmapWrap>(
+      pixmap_obj->ToObject());
+  QPixmap pixmap = *pixmap_wrap->GetWrapped();
+
+  // The callback may have removed or resized the layer, or bumped its
+  // version; the next paint renders it again then
+  if (layer->removed || layer->rect.size() != size)
+    return pixmap;
+
+  // Layers larger than QPixmapCache::cacheLimit() won't be inserted and are
+  // simply re-rendered on every paint
+  QPixmapCache::remove(layer->key);
+  layer->key = QPixmapCache::insert(pixmap);
+  layer->cachedVersion = version;
+
+  return pixmap;
 }
 
-void QWidgetImpl::mouseReleaseEvent(QMouseEvent* e) {
-  e->ignore(); // ensures event bubbles up
+// Showing a movie that is already shown just moves it
+void QWidgetImpl::addMovie(Handle<Object> handle, QMovieImpl* movie,
+                           const QPoint& pos) {
+  removeMovie(movie);
 
-  NanScope();
+  QWidgetMovie* m = new QWidgetMovie;
+  m->movie = movie;
+  m->pos = pos;
+  NanAssignPersistent(Object, m->handle, handle);
+  movies_.append(m);
 
-  if (!NanPersistentToLocal(mouseReleaseCallback_)->IsFunction())
-    return;
+  movie->addView(this, pos);
+}
 
-  const unsigned argc = 1;
-  Handle<Value> argv[argc] = {
-    QMouseEventWrap::NewInstance(*e)
+void QWidgetImpl::removeMovie(QMovieImpl* movie) {
+  for (int i = movies_.size() - 1; i >= 0; --i) {
+    QWidgetMovie* m = movies_[i];
+    if (m->movie != movie)
+      continue;
+
+    movie->removeView(this);
+    movies_.removeAt(i);
+    NanDispose(m->handle);
+    delete m;
+  }
+}
+
+QImage QWidgetImpl::grab(const QRect& rect) {
+  QRect source = rect.isNull() ? this->rect() : rect & this->rect();
+
+  QImage image(source.size(), QImage::Format_ARGB32_Premultiplied);
+  image.fill(0);
+  renderOffscreen(&image, QPoint(), QRegion(source));
+
+  return image;
+}
+
+void QWidgetImpl::renderOffscreen(QPaintDevice* target, const QPoint& offset,
+                                  const QRegion& source) {
+  ++offscreen_;
+  render(target, offset, source);
+  --offscreen_;
+}
+
+void QWidgetImpl::setCapture(FrameCapture* capture) {
+  capture_ = capture;
+  update();
+}
+
+bool QWidgetImpl::beginPaint(QPainter* painter) {
+  if (!paintCanvas_)
+    return painter->begin(this);
+
+  if (!painter->begin(paintCanvas_))
+    return false;
+  painter->setClipRegion(paintRegion_);
+  return true;
+}
+
+//
+// QWidgetSnapshots
+// Queue behind grabAsync(). Every widget queued during one turn of the
+// event loop is rendered in a single pass on the next one
+//
+class QWidgetSnapshots : public QObject {
+ public:
+  static void enqueue(QWidgetImpl* widget, Handle<Object> handle,
+                      Handle<Function> callback);
+
+ protected:
+  void timerEvent(QTimerEvent* e);
+
+ private:
+  struct Job {
+    QPointer<QWidgetImpl> widget;
+    Persistent<Object> handle;
+    Persistent<Function> callback;
   };
-  Handle<Function> cb = NanPersistentToLocal(Persistent<Function>::Cast(mouseReleaseCallback_));
 
-  cb->Call(Context::GetCurrent()->Global(), argc, argv);
+  QList<Job> jobs_;
+  QBasicTimer timer_;
+};
+
+void QWidgetSnapshots::enqueue(QWidgetImpl* widget, Handle<Object> handle,
+                               Handle<Function> callback) {
+  static QWidgetSnapshots* queue = new QWidgetSnapshots;
+
+  Job job;
+  job.widget = widget;
+  NanAssignPersistent(Object, job.handle, handle);
+  NanAssignPersistent(Function, job.callback, callback);
+  queue->jobs_.append(job);
+
+  if (!queue->timer_.isActive())
+    queue->timer_.start(0, queue);
 }
 
-void QWidgetImpl::mouseMoveEvent(QMouseEvent* e) {
-  e->ignore(); // ensures event bubbles up
+// Calls back with (error, image)
+void QWidgetSnapshots::timerEvent(QTimerEvent* e) {
+  if (e->timerId() != timer_.timerId()) {
+    QObject::timerEvent(e);
+    return;
+  }
 
-  NanScope();
+  timer_.stop();
+
+  // Callbacks may queue more snapshots; those wait for the next turn
+  QList<Job> jobs = jobs_;
+  jobs_.clear();
+
+  for (int i = 0; i < jobs.size(); ++i) {
+    NanScope();
+
+    const unsigned argc = 2;
+    Handle<Value> argv[argc];
+    if (jobs[i].widget) {
+      argv[0] = Null();
+      argv[1] = QImageWrap::NewInstance(jobs[i].widget->grab());
+    } else {
+      argv[0] = Exception::Error(
+          String::New("QWidget::grabAsync: widget was destroyed"));
+      argv[1] = Undefined();
+    }
+
+    Local<Function> cb = NanPersistentToLocal(jobs[i].callback);
+    NanDispose(jobs[i].callback);
+    NanDispose(jobs[i].handle);
+
+    cb->Call(Context::GetCurrent()->Global(), argc, argv);
+  }
+}
+
+void QWidgetImpl::paintMovies(const QRect& exposed) {
+  QPainter painter;
+  beginPaint(&painter);
 
-  if (!NanPersistentToLocal(mouseMoveCallback_)->IsFunction())
+  for (int i = 0; i < movies_.size(); ++i) {
+    const QImage& image = movies_[i]->movie->currentImage();
+    QRect rect(movies_[i]->pos, image.size());
+    if (!image.isNull() && rect.intersects(exposed))
+      painter.drawImage(rect.topLeft(), image);
+  }
+}
+
+// Replaces any callback already subscribed to the type. With plain, key
+// events are passed as plain objects instead of QKeyEvent wrappers
+void QWidgetImpl::on(int type, Handle<Function> callback, bool plain) {
+  off(type);
+
+  NanAssignPersistent(Function, handlers_[type], callback);
+  subscribed_[type >> 5] |= 1u << (type & 31);
+  if (plain)
+    plain_[type >> 5] |= 1u << (type & 31);
+
+  // Qt only delivers these to widgets that opt in
+  if (type == QEvent::HoverEnter || type == QEvent::HoverLeave ||
+      type == QEvent::HoverMove)
+    setAttribute(Qt::WA_Hover);
+  if (type == QEvent::TouchBegin || type == QEvent::TouchUpdate ||
+      type == QEvent::TouchEnd)
+    setAttribute(Qt::WA_AcceptTouchEvents);
+}
+
+void QWidgetImpl::off(int type) {
+  QHash<int, Persistent<Function> >::iterator it = handlers_.find(type);
+  if (it == handlers_.end())
     return;
 
-  const unsigned argc = 1;
+  NanDispose(it.value());
+  handlers_.erase(it);
+  subscribed_[type >> 5] &= ~(1u << (type & 31));
+  plain_[type >> 5] &= ~(1u << (type & 31));
+}
+
+// Types outside wheel, touch, tablet and mouse move are ignored. Replaces
+// any previous subscription; pending records are dropped
+void QWidgetImpl::setInputEvents(const QList<int>& types,
+                                 Handle<Function> callback) {
+  clearInputEvents();
+
+  for (int i = 0; i < types.size(); ++i) {
+    switch (types[i]) {
+      case QEvent::TouchBegin:
+      case QEvent::TouchUpdate:
+      case QEvent::TouchEnd:
+        setAttribute(Qt::WA_AcceptTouchEvents);
+        // fall through
+      case QEvent::Wheel:
+      case QEvent::TabletMove:
+      case QEvent::TabletPress:
+      case QEvent::TabletRelease:
+      case QEvent::MouseMove:
+        batched_[types[i] >> 5] |= 1u << (types[i] & 31);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // One buffer and one JS view per widget, reused for every batch
+  if (!input_) {
+    input_ = new double[InputStride * InputCapacity];
+
+    NanScope();
+    Local<Object> records = Object::New();
+    records->SetIndexedPropertiesToExternalArrayData(
+        input_, kExternalDoubleArray, InputStride * InputCapacity);
+    NanAssignPersistent(Object, inputRecords_, records);
+  }
+
+  NanAssignPersistent(Function, inputCallback_, callback);
+}
+
+void QWidgetImpl::clearInputEvents() {
+  memset(batched_, 0, sizeof(batched_));
+  inputCount_ = 0;
+  inputPending_.removeOne(this);
+  NanDispose(inputCallback_);
+}
+
+// Calls back with (records, count). The records object is overwritten by
+// the next batch
+void QWidgetImpl::flushInput() {
+  if (inputCount_ == 0)
+    return;
+
+  NanScope();
+
+  const unsigned argc = 2;
   Handle<Value> argv[argc] = {
-    QMouseEventWrap::NewInstance(*e)
+    NanPersistentToLocal(inputRecords_),
+    Integer::New(inputCount_)
   };
-  Handle<Function> cb = NanPersistentToLocal(Persistent<Function>::Cast(mouseMoveCallback_));
+  Handle<Function> cb = NanPersistentToLocal(inputCallback_);
+
+  inputCount_ = 0;
+  inputPending_.removeOne(this);
 
   cb->Call(Context::GetCurrent()->Global(), argc, argv);
 }
 
-void QWidgetImpl::keyPressEvent(QKeyEvent* e) {
-  e->ignore(); // ensures event bubbles up
+void QWidgetImpl::flushAllInput() {
+  while (!inputPending_.isEmpty())
+    inputPending_.first()->flushInput();
+}
 
-  NanScope();
+// NULL once input is no longer batched
+double* QWidgetImpl::nextRecord() {
+  if (inputCount_ == InputCapacity)
+    flushInput();
+
+  // flushInput() runs JS, which may have called inputEvents(null)
+  if (inputCallback_.IsEmpty())
+    return NULL;
+
+  if (inputCount_ == 0)
+    inputPending_.append(this);
 
-  if (!NanPersistentToLocal(keyPressCallback_)->IsFunction())
+  return input_ + InputStride * inputCount_++;
+}
+
+static void FillRecord(double* r, int type, qreal x, qreal y, qreal value,
+                       qreal value2, qreal value3, qreal id, int modifiers) {
+  if (!r)
     return;
 
-  const unsigned argc = 1;
-  Handle<Value> argv[argc] = {
-    QKeyEventWrap::NewInstance(*e)
-  };
-  Handle<Function> cb = NanPersistentToLocal(Persistent<Function>::Cast(keyPressCallback_));
+  r[0] = type;
+  r[1] = x;
+  r[2] = y;
+  r[3] = value;
+  r[4] = value2;
+  r[5] = value3;
+  r[6] = id;
+  r[7] = modifiers;
+}
 
-  cb->Call(Context::GetCurrent()->Global(), argc, argv);
+void QWidgetImpl::batchInput(QEvent* e) {
+  int type = e->type();
+
+  switch (type) {
+    case QEvent::Wheel: {
+      QWheelEvent* w = static_cast<QWheelEvent*>(e);
+      FillRecord(nextRecord(), type, w->x(), w->y(), w->delta(),
+                 w->orientation(), w->buttons(), 0, w->modifiers());
+      break;
+    }
+    case QEvent::MouseMove: {
+      QMouseEvent* m = static_cast<QMouseEvent*>(e);
+      FillRecord(nextRecord(), type, m->x(), m->y(), m->buttons(), 0, 0, 0,
+                 m->modifiers());
+      break;
+    }
+    case QEvent::TabletMove:
+    case QEvent::TabletPress:
+    case QEvent::TabletRelease: {
+      // pos() is truncated to ints; the fraction is in the hi-res global
+      // position
+      QTabletEvent* t = static_cast<QTabletEvent*>(e);
+      FillRecord(nextRecord(), type,
+                 t->x() + (t->hiResGlobalX() - t->globalX()),
+                 t->y() + (t->hiResGlobalY() - t->globalY()),
+                 t->pressure(), t->xTilt(), t->yTilt(), t->uniqueId(),
+                 t->modifiers());
+      break;
+    }
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd: {
+      // One record per touch point
+      QTouchEvent* t = static_cast<QTouchEvent*>(e);
+      const QList<QTouchEvent::TouchPoint>& points = t->touchPoints();
+      for (int i = 0; i < points.size(); ++i) {
+        const QTouchEvent::TouchPoint& p = points[i];
+        FillRecord(nextRecord(), type, p.pos().x(), p.pos().y(),
+                   p.pressure(), p.state(), 0, p.id(), t->modifiers());
+      }
+      break;
+    }
+    default:
+      break;
+  }
 }
 
-void QWidgetImpl::keyReleaseEvent(QKeyEvent* e) {
-  e->ignore(); // ensures event bubbles up
+//
+// EventObject()
+// Plain-object description of events that have no wrapper class
+//
+static Handle<Value> EventObject(QEvent* e) {
+  HandleScope scope;
+
+  Local<Object> obj = Object::New();
+  obj->Set(String::NewSymbol("type"), Integer::New(e->type()));
+
+  switch (e->type()) {
+    case QEvent::Resize: {
+      QResizeEvent* r = static_cast<QResizeEvent*>(e);
+      obj->Set(String::NewSymbol("width"), Integer::New(r->size().width()));
+      obj->Set(String::NewSymbol("height"), Integer::New(r->size().height()));
+      obj->Set(String::NewSymbol("oldWidth"),
+               Integer::New(r->oldSize().width()));
+      obj->Set(String::NewSymbol("oldHeight"),
+               Integer::New(r->oldSize().height()));
+      break;
+    }
+    case QEvent::Move: {
+      QMoveEvent* m = static_cast<QMoveEvent*>(e);
+      obj->Set(String::NewSymbol("x"), Integer::New(m->pos().x()));
+      obj->Set(String::NewSymbol("y"), Integer::New(m->pos().y()));
+      obj->Set(String::NewSymbol("oldX"), Integer::New(m->oldPos().x()));
+      obj->Set(String::NewSymbol("oldY"), Integer::New(m->oldPos().y()));
+      break;
+    }
+    case QEvent::Wheel: {
+      QWheelEvent* w = static_cast<QWheelEvent*>(e);
+      obj->Set(String::NewSymbol("x"), Integer::New(w->x()));
+      obj->Set(String::NewSymbol("y"), Integer::New(w->y()));
+      obj->Set(String::NewSymbol("delta"), Integer::New(w->delta()));
+      obj->Set(String::NewSymbol("orientation"),
+               Integer::New(w->orientation()));
+      obj->Set(String::NewSymbol("buttons"), Integer::New(w->buttons()));
+      obj->Set(String::NewSymbol("modifiers"), Integer::New(w->modifiers()));
+      break;
+    }
+    case QEvent::FocusIn:
+    case QEvent::FocusOut: {
+      QFocusEvent* f = static_cast<QFocusEvent*>(e);
+      obj->Set(String::NewSymbol("reason"), Integer::New(f->reason()));
+      break;
+    }
+    default:
+      break;
+  }
+
+  return scope.Close(obj);
+}
 
+// Only called for subscribed types
+void QWidgetImpl::dispatch(QEvent* e) {
   NanScope();
 
-  if (!NanPersistentToLocal(keyReleaseCallback_)->IsFunction())
-    return;
+  unsigned argc = 1;
+  Handle<Value> argv[1];
+
+  switch (e->type()) {
+    case QEvent::Paint:
+      argc = 0;
+      break;
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove:
+      argv[0] = QMouseEventWrap::NewInstance(*static_cast<QMouseEvent*>(e));
+      break;
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+      if (plain_[e->type() >> 5] & (1u << (e->type() & 31)))
+        argv[0] = QKeyEventWrap::NewPlainObject(*static_cast<QKeyEvent*>(e));
+      else
+        argv[0] = QKeyEventWrap::NewInstance(*static_cast<QKeyEvent*>(e));
+      break;
+    default:
+      argv[0] = EventObject(e);
+      break;
+  }
 
-  const unsigned argc = 1;
-  Handle<Value> argv[argc] = {
-    QKeyEventWrap::NewInstance(*e)
-  };
-  Handle<Function> cb = NanPersistentToLocal(Persistent<Function>::Cast(keyReleaseCallback_));
+  Handle<Function> cb = NanPersistentToLocal(handlers_.value(e->type()));
 
   cb->Call(Context::GetCurrent()->Global(), argc, argv);
 }
 
+// Callbacks run before Qt's own handling, so mouse and key events still
+// bubble up to the parent as before
+bool QWidgetImpl::event(QEvent* e) {
+  int type = e->type();
+
+  if (isBatched(type)) {
+    batchInput(e);
+  } else if (type != QEvent::Paint && isSubscribed(type)) {
+    // Paint callbacks run from paintEvent(), on top of layers and movies
+    flushInput();
+    dispatch(e);
+  }
+
+  // Unaccepted touches turn into synthesized mouse events and Qt stops
+  // sending the rest of the sequence, so take all of them as long as any
+  // touch type is wanted, batched or not
+  if (type == QEvent::TouchBegin || type == QEvent::TouchUpdate ||
+      type == QEvent::TouchEnd) {
+    for (int t = QEvent::TouchBegin; t <= QEvent::TouchEnd; ++t) {
+      if (isBatched(t) || isSubscribed(t)) {
+        e->accept();
+        return true;
+      }
+    }
+  }
+
+  return QWidget::event(e);
+}
+
+void QWidgetImpl::paintEvent(QPaintEvent* e) {
+  // Qt's backing store redirection takes precedence over
+  // QPainter::setRedirected(), so captured paints are sent to the canvas
+  // by beginPaint() instead. The canvas starts from the widget background,
+  // as the backing store would
+  FrameCapture* capture = offscreen_ ? NULL : capture_;
+  if (capture) {
+    paintCanvas_ = capture->beginFrame(size());
+    paintRegion_ = e->region();
+
+    QPainter background(paintCanvas_);
+    background.setCompositionMode(QPainter::CompositionMode_Source);
+    background.setClipRegion(paintRegion_);
+    background.fillRect(rect(), palette().brush(backgroundRole()));
+  }
+
+  if (!layers_.isEmpty())
+    paintLayers(e->rect());
+
+  if (!movies_.isEmpty())
+    paintMovies(e->rect());
+
+  if (isSubscribed(QEvent::Paint)) {
+    flushInput();
+    dispatch(e);
+  }
+
+  if (paintCanvas_) {
+    QImage* canvas = paintCanvas_;
+    paintCanvas_ = NULL;
+
+    QPainter painter(this);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.setClipRegion(paintRegion_);
+    painter.drawImage(0, 0, *canvas);
+    painter.end();
+
+    // beginFrame() referenced the capture, so the canvas is still there
+    // even if the paint callback stopped it; endFrame() drops the reference
+    capture->endFrame(paintRegion_);
+    paintRegion_ = QRegion();
+  }
+}
+
 //
 // QWidgetWrap()
 //
@@ -212,7 +757,33 @@ void QWidgetWrap::Initialize(Handle<Object> target) {
   tpl->PrototypeTemplate()->Set(String::NewSymbol("y"),
       FunctionTemplate::New(Y)->GetFunction());
 
+  // Layer cache
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setLayer"),
+      FunctionTemplate::New(SetLayer)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("setLayerVersion"),
+      FunctionTemplate::New(SetLayerVersion)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("removeLayer"),
+      FunctionTemplate::New(RemoveLayer)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addMovie"),
+      FunctionTemplate::New(AddMovie)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("removeMovie"),
+      FunctionTemplate::New(RemoveMovie)->GetFunction());
+
+  // Offscreen rendering
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("render"),
+      FunctionTemplate::New(Render)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("grab"),
+      FunctionTemplate::New(Grab)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("grabAsync"),
+      FunctionTemplate::New(GrabAsync)->GetFunction());
+
   // Events
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("on"),
+      FunctionTemplate::New(On)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("off"),
+      FunctionTemplate::New(Off)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("inputEvents"),
+      FunctionTemplate::New(InputEvents)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("paintEvent"),
       FunctionTemplate::New(PaintEvent)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("mousePressEvent"),
@@ -232,6 +803,10 @@ void QWidgetWrap::Initialize(Handle<Object> target) {
 
 NAN_METHOD(QWidgetWrap::New) {
   NanScope();
+
+  if (!QApplicationWrap::HasGui())
+    return NanThrowError("QWidget::QWidget: application was created without gui");
+
   QWidgetImpl* q_parent = 0;
 
   if (args.Length() > 0) {
@@ -340,6 +915,104 @@ NAN_METHOD(QWidgetWrap::Parent) {
   NanReturnValue(qt_v8::FromQString(q->parent()->objectName()));
 }
 
+//
+// On()
+// Subscribes a callback to a QEvent::Type (see qt.EventType). Mouse and key
+// events are passed as QMouseEvent/QKeyEvent, paint callbacks get no
+// argument, and everything else gets a plain object with the event's type
+// and fields. on(type, callback, { plain: true }) delivers key events as
+// plain { key, text, modifiers, autoRepeat, count, timestamp } objects
+// instead, saving a native call per field
+//
+NAN_METHOD(QWidgetWrap::On) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  if (!args[0]->IsNumber() || !args[1]->IsFunction())
+    return NanThrowTypeError("QWidget::on: bad arguments");
+
+  int type = args[0]->Int32Value();
+  if (type < 0 || type >= QWidgetImpl::MaxRoutedEvent)
+    return NanThrowRangeError("QWidget::on: unsupported event type");
+
+  bool plain = false;
+  if (args[2]->IsObject())
+    plain = args[2]->ToObject()->Get(String::NewSymbol("plain"))->BooleanValue();
+
+  q->on(type, Local<Function>::Cast(args[1]), plain);
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QWidgetWrap::Off) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  q->off(args[0]->Int32Value());
+
+  NanReturnUndefined();
+}
+
+//
+// InputEvents()
+// Subscribes a callback to batched wheel, touch, tablet and mouse move
+// events: inputEvents([qt.EventType.Wheel, ...], function(records, count))
+// Record i spans records[i * qt.InputRecord.Stride] onwards. Batched types
+// are no longer delivered to on() callbacks. Passing anything but a
+// function unsubscribes
+//
+NAN_METHOD(QWidgetWrap::InputEvents) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  if (!args[1]->IsFunction()) {
+    q->clearInputEvents();
+    NanReturnUndefined();
+  }
+
+  if (!args[0]->IsArray())
+    return NanThrowTypeError("QWidget::inputEvents: bad arguments");
+
+  Local<Array> array = Local<Array>::Cast(args[0]);
+  QList<int> types;
+  for (uint32_t i = 0; i < array->Length(); ++i) {
+    int type = array->Get(i)->Int32Value();
+    switch (type) {
+      case QEvent::Wheel:
+      case QEvent::MouseMove:
+      case QEvent::TabletMove:
+      case QEvent::TabletPress:
+      case QEvent::TabletRelease:
+      case QEvent::TouchBegin:
+      case QEvent::TouchUpdate:
+      case QEvent::TouchEnd:
+        types.append(type);
+        break;
+      default:
+        return NanThrowRangeError(
+            "QWidget::inputEvents: event type can't be batched");
+    }
+  }
+
+  q->setInputEvents(types, Local<Function>::Cast(args[1]));
+
+  NanReturnUndefined();
+}
+
+// Anything but a function unbinds
+static void BindEvent(QWidgetImpl* q, int type, Handle<Value> callback) {
+  if (callback->IsFunction())
+    q->on(type, Handle<Function>::Cast(callback));
+  else
+    q->off(type);
+}
+
 //
 // PaintEvent()
 // Binds a callback to Qt's event
@@ -350,7 +1023,7 @@ NAN_METHOD(QWidgetWrap::PaintEvent) {
   QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
   QWidgetImpl* q = w->GetWrapped();
 
-  NanAssignPersistent(Function, q->paintEventCallback_, Local<Function>::Cast(args[0]));
+  BindEvent(q, QEvent::Paint, args[0]);
 
   NanReturnUndefined();
 }
@@ -365,7 +1038,7 @@ NAN_METHOD(QWidgetWrap::MousePressEvent) {
   QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
   QWidgetImpl* q = w->GetWrapped();
 
-  NanAssignPersistent(Function, q->mousePressCallback_, Local<Function>::Cast(args[0]));
+  BindEvent(q, QEvent::MouseButtonPress, args[0]);
 
   NanReturnUndefined();
 }
@@ -380,7 +1053,7 @@ NAN_METHOD(QWidgetWrap::MouseReleaseEvent) {
   QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
   QWidgetImpl* q = w->GetWrapped();
 
-  NanAssignPersistent(Function, q->mouseReleaseCallback_, Local<Function>::Cast(args[0]));
+  BindEvent(q, QEvent::MouseButtonRelease, args[0]);
 
   NanReturnUndefined();
 }
@@ -395,7 +1068,7 @@ NAN_METHOD(QWidgetWrap::MouseMoveEvent) {
   QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
   QWidgetImpl* q = w->GetWrapped();
 
-  NanAssignPersistent(Function, q->mouseMoveCallback_, Local<Function>::Cast(args[0]));
+  BindEvent(q, QEvent::MouseMove, args[0]);
 
   NanReturnUndefined();
 }
@@ -410,7 +1083,7 @@ NAN_METHOD(QWidgetWrap::KeyPressEvent) {
   QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
   QWidgetImpl* q = w->GetWrapped();
 
-  NanAssignPersistent(Function, q->keyPressCallback_, Local<Function>::Cast(args[0]));
+  BindEvent(q, QEvent::KeyPress, args[0]);
 
   NanReturnUndefined();
 }
@@ -425,7 +1098,7 @@ NAN_METHOD(QWidgetWrap::KeyReleaseEvent) {
   QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
   QWidgetImpl* q = w->GetWrapped();
 
-  NanAssignPersistent(Function, q->keyReleaseCallback_, Local<Function>::Cast(args[0]));
+  BindEvent(q, QEvent::KeyRelease, args[0]);
 
   NanReturnUndefined();
 }
@@ -502,3 +1175,201 @@ NAN_METHOD(QWidgetWrap::Y) {
 
   NanReturnValue(Integer::New(q->y()));
 }
+
+//
+// SetLayer()
+// Declares a cached layer covering the given rect. callback(pixmap) is
+// invoked to (re)paint the layer's pixmap, which is then reused by every
+// paint event until the layer's version changes.
+// The callback must end() any painter it begins on the pixmap.
+//
+// Supported implementations:
+//    setLayer (String name, int x, int y, int w, int h, int version,
+//              Function callback)
+NAN_METHOD(QWidgetWrap::SetLayer) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  if (!args[0]->IsString() || !args[1]->IsNumber() || !args[2]->IsNumber() ||
+      !args[3]->IsNumber() || !args[4]->IsNumber() || !args[5]->IsNumber() ||
+      !args[6]->IsFunction())
+    return NanThrowTypeError("QWidgetWrap::SetLayer: bad arguments");
+
+  QRect rect(args[1]->IntegerValue(), args[2]->IntegerValue(),
+             args[3]->IntegerValue(), args[4]->IntegerValue());
+
+  if (rect.isEmpty())
+    return NanThrowTypeError("QWidgetWrap::SetLayer: layer size is empty");
+
+  q->setLayer(qt_v8::ToQString(args[0]->ToString()), rect,
+              args[5]->IntegerValue(), Local<Function>::Cast(args[6]));
+
+  NanReturnUndefined();
+}
+
+//
+// SetLayerVersion()
+// Bumping a layer's version invalidates its cached pixmap. Setting the
+// version it already has is a no-op
+//
+NAN_METHOD(QWidgetWrap::SetLayerVersion) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  QWidgetLayer* layer = q->layer(qt_v8::ToQString(args[0]->ToString()));
+  if (!layer)
+    return NanThrowError("QWidgetWrap::SetLayerVersion: no such layer");
+
+  q->setLayerVersion(layer, args[1]->IntegerValue());
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QWidgetWrap::RemoveLayer) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  QWidgetLayer* layer = q->layer(qt_v8::ToQString(args[0]->ToString()));
+  if (layer)
+    q->removeLayer(layer);
+
+  NanReturnUndefined();
+}
+
+//
+// AddMovie()
+// Shows a QMovie with its top left at (x, y), above any layers
+//
+NAN_METHOD(QWidgetWrap::AddMovie) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  QString arg0_constructor;
+  if (args[0]->IsObject()) {
+    arg0_constructor =
+        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  }
+
+  if (arg0_constructor != "QMovie")
+    return NanThrowTypeError("QWidgetWrap::AddMovie: bad arguments");
+
+  QMovieWrap* movie_wrap = node::ObjectWrap::Unwrap<QMovieWrap>(
+      args[0]->ToObject());
+
+  q->addMovie(args[0]->ToObject(), movie_wrap->GetWrapped(),
+              QPoint(args[1]->IntegerValue(), args[2]->IntegerValue()));
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QWidgetWrap::RemoveMovie) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  QString arg0_constructor;
+  if (args[0]->IsObject()) {
+    arg0_constructor =
+        qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+  }
+
+  if (arg0_constructor != "QMovie")
+    return NanThrowTypeError("QWidgetWrap::RemoveMovie: bad arguments");
+
+  QMovieWrap* movie_wrap = node::ObjectWrap::Unwrap<QMovieWrap>(
+      args[0]->ToObject());
+  q->removeMovie(movie_wrap->GetWrapped());
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   render(QImage|QPixmap target)
+//   render(QImage|QPixmap target, x, y)
+//   render(QImage|QPixmap target, x, y, sx, sy, sw, sh)
+//
+// Paints the widget into target at (x, y), optionally only the source
+// rectangle (sx, sy, sw, sh) of it. The widget doesn't need to be shown
+NAN_METHOD(QWidgetWrap::Render) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  if (!args[0]->IsObject())
+    return NanThrowTypeError("QWidget::render: bad arguments");
+
+  QString constructor_name =
+    qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+
+  QPaintDevice* target = NULL;
+  if (constructor_name == "QImage") {
+    target = node::ObjectWrap::Unwrap<QImageWrap>(
+        args[0]->ToObject())->GetWrapped();
+  } else if (constructor_name == "QPixmap") {
+    target = node::ObjectWrap::Unwrap<QPixmapWrap>(
+        args[0]->ToObject())->GetWrapped();
+  } else {
+    return NanThrowTypeError("QWidget::render: bad arguments");
+  }
+
+  QPoint offset(args[1]->IntegerValue(), args[2]->IntegerValue());
+
+  QRegion source;
+  if (args.Length() >= 7) {
+    source = QRegion(args[3]->IntegerValue(), args[4]->IntegerValue(),
+                     args[5]->IntegerValue(), args[6]->IntegerValue());
+  }
+
+  q->renderOffscreen(target, offset, source);
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   grab()
+//   grab(x, y, w, h)
+//
+// Returns a QImage (Format_ARGB32_Premultiplied) of the widget or of the
+// given rectangle of it
+NAN_METHOD(QWidgetWrap::Grab) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  QRect rect;
+  if (args.Length() >= 4) {
+    rect = QRect(args[0]->IntegerValue(), args[1]->IntegerValue(),
+                 args[2]->IntegerValue(), args[3]->IntegerValue());
+  }
+
+  NanReturnValue(QImageWrap::NewInstance(q->grab(rect)));
+}
+
+// QUIRK:
+// Widgets can only be painted from the main thread; grabAsync() batches the
+// snapshots of one event loop turn rather than moving them to a worker.
+// The application must keep calling processEvents()
+NAN_METHOD(QWidgetWrap::GrabAsync) {
+  NanScope();
+
+  QWidgetWrap* w = node::ObjectWrap::Unwrap<QWidgetWrap>(args.This());
+  QWidgetImpl* q = w->GetWrapped();
+
+  if (!args[0]->IsFunction())
+    return NanThrowTypeError("QWidget::grabAsync: bad arguments");
+
+  QWidgetSnapshots::enqueue(q, args.This(), Local<Function>::Cast(args[0]));
+
+  NanReturnUndefined();
+}
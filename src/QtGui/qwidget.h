@@ -32,8 +32,43 @@
 
 #include <node.h>
 #include <QWidget>
+#include <QList>
+#include <QHash>
+#include <QPixmapCache>
 #include <nan.h>
 
+//
+// QWidgetLayer
+// A named rectangle of the widget whose contents are rendered by a JS
+// callback into an offscreen pixmap. The pixmap lives in QPixmapCache and
+// is only re-rendered when the layer's version changes (or the cache
+// evicted it)
+//
+struct QWidgetLayer {
+  QString name;
+  QRect rect;
+  int version;
+  int cachedVersion;
+  QPixmapCache::Key key;
+  v8::Persistent<v8::Function> paintCallback;
+  // Removed while its callback was running; freed after the paint
+  bool removed;
+};
+
+class QMovieImpl;
+class FrameCapture;
+
+//
+// QWidgetMovie
+// A QMovie shown at a fixed position. The JS handle keeps the movie alive
+// while the widget shows it
+//
+struct QWidgetMovie {
+  QMovieImpl* movie;
+  QPoint pos;
+  v8::Persistent<v8::Object> handle;
+};
+
 //
 // QWidgetImpl()
 // Extends QWidget to implement virtual methods from QWidget
@@ -42,20 +77,95 @@ class QWidgetImpl : public QWidget {
  public:
   QWidgetImpl(QWidgetImpl* parent);
   ~QWidgetImpl();
-  v8::Persistent<v8::Value> paintEventCallback_;
-  v8::Persistent<v8::Value> mousePressCallback_;
-  v8::Persistent<v8::Value> mouseReleaseCallback_;
-  v8::Persistent<v8::Value> mouseMoveCallback_;
-  v8::Persistent<v8::Value> keyPressCallback_;
-  v8::Persistent<v8::Value> keyReleaseCallback_;
+
+  // Event router. One JS callback per QEvent::Type; types nobody subscribed
+  // to are filtered by a bitmask and never touch V8
+  enum { MaxRoutedEvent = 256 };
+  void on(int type, v8::Handle<v8::Function> callback, bool plain = false);
+  void off(int type);
+  bool isSubscribed(int type) const {
+    return type >= 0 && type < MaxRoutedEvent &&
+           (subscribed_[type >> 5] & (1u << (type & 31)));
+  }
+
+  // High-rate input (wheel, touch, tablet, mouse move) subscribed with
+  // setInputEvents() is packed into fixed-size records of doubles (see
+  // qt.InputRecord) and handed to JS in batches: when the buffer fills up,
+  // before any other routed event, before paint callbacks and after
+  // QApplication::processEvents()
+  enum { InputStride = 8, InputCapacity = 512 };
+  void setInputEvents(const QList<int>& types,
+                      v8::Handle<v8::Function> callback);
+  void clearInputEvents();
+  void flushInput();
+  static void flushAllInput();
+
+  // Layers are composited in declaration order, below whatever the
+  // QEvent::Paint callback paints
+  QWidgetLayer* layer(const QString& name) const;
+  void setLayer(const QString& name, const QRect& rect, int version,
+                v8::Handle<v8::Function> callback);
+  void setLayerVersion(QWidgetLayer* layer, int version);
+  void removeLayer(QWidgetLayer* layer);
+
+  // Movies are painted above the layers. The movie schedules repaints of
+  // just the area that changes from frame to frame
+  void addMovie(v8::Handle<v8::Object> handle, QMovieImpl* movie,
+                const QPoint& pos);
+  void removeMovie(QMovieImpl* movie);
+
+  // Renders the widget (or part of it) offscreen through QWidget::render,
+  // without showing it. Paint callbacks run as for a normal repaint
+  QImage grab(const QRect& rect = QRect());
+  // QWidget::render for offscreen targets. Such paints are never captured
+  void renderOffscreen(QPaintDevice* target, const QPoint& offset,
+                       const QRegion& source);
+
+  // While a FrameCapture is attached, the widget paints into the
+  // capture's canvas and copies the exposed region of it to the screen,
+  // so each frame can be read back without rendering it again
+  void setCapture(FrameCapture* capture);
+  FrameCapture* capture() const { return capture_; }
+  // Begins painter on the widget, or on the capture canvas (clipped to
+  // the exposed region) during a captured paint
+  bool beginPaint(QPainter* painter);
 
  private:
+  void paintLayers(const QRect& exposed);
+  QPixmap renderLayer(QWidgetLayer* layer);
+  void deleteLayer(QWidgetLayer* layer);
+  QList<QWidgetLayer*> layers_;
+  bool paintingLayers_;
+  QList<QWidgetLayer*> removedLayers_;
+
+  void paintMovies(const QRect& exposed);
+  QList<QWidgetMovie*> movies_;
+
+  FrameCapture* capture_;
+  QImage* paintCanvas_;
+  QRegion paintRegion_;
+  static int offscreen_;
+
+  void dispatch(QEvent* e);
+  quint32 subscribed_[MaxRoutedEvent / 32];
+  quint32 plain_[MaxRoutedEvent / 32];
+  QHash<int, v8::Persistent<v8::Function> > handlers_;
+
+  bool isBatched(int type) const {
+    return type >= 0 && type < MaxRoutedEvent &&
+           (batched_[type >> 5] & (1u << (type & 31)));
+  }
+  void batchInput(QEvent* e);
+  double* nextRecord();
+  quint32 batched_[MaxRoutedEvent / 32];
+  double* input_;
+  int inputCount_;
+  v8::Persistent<v8::Object> inputRecords_;
+  v8::Persistent<v8::Function> inputCallback_;
+  static QList<QWidgetImpl*> inputPending_;
+
+  bool event(QEvent* e);
   void paintEvent(QPaintEvent* e);
-  void mousePressEvent(QMouseEvent* e);
-  void mouseReleaseEvent(QMouseEvent* e);
-  void mouseMoveEvent(QMouseEvent* e);
-  void keyPressEvent(QKeyEvent* e);
-  void keyReleaseEvent(QKeyEvent* e);
 };
 
 //
@@ -90,10 +200,27 @@ class QWidgetWrap : public node::ObjectWrap {
   static NAN_METHOD(X);
   static NAN_METHOD(Y);
 
+  // Layer cache
+  static NAN_METHOD(SetLayer);
+  static NAN_METHOD(SetLayerVersion);
+  static NAN_METHOD(RemoveLayer);
+
+  // Movies
+  static NAN_METHOD(AddMovie);
+  static NAN_METHOD(RemoveMovie);
+
+  // Offscreen rendering
+  static NAN_METHOD(Render);
+  static NAN_METHOD(Grab);
+  static NAN_METHOD(GrabAsync);
+
   // QUIRK
-  // Event binding. These functions bind implemented event handlers above
-  // to the given callbacks. This is necessary as in Qt such handlers
-  // are virtual and we can't dynamically implement them from JS
+  // Event binding. Qt's handlers are virtual and can't be implemented from
+  // JS, so QWidgetImpl routes events to callbacks registered here. The
+  // xxxEvent() setters are shorthands for on() with a fixed type
+  static NAN_METHOD(On);
+  static NAN_METHOD(Off);
+  static NAN_METHOD(InputEvents);
   static NAN_METHOD(PaintEvent);
   static NAN_METHOD(MousePressEvent);
   static NAN_METHOD(MouseReleaseEvent);
@@ -28,14 +28,51 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <node.h>
+#include <qtesttouch.h>
 #include "../qt_v8.h"
 #include "../QtGui/qwidget.h"
+#include "../QtGui/qgraphicsview.h"
 #include "qtesteventlist.h"
 
 using namespace v8;
 
 Persistent<Function> QTestEventListWrap::constructor;
 
+//
+// QTestTouchEvent
+// One touch point changing state, committed as its own touch event through
+// QTest::touchEvent(). QTestEventList only knows mouse, key and delay
+// events
+//
+class QTestTouchEvent : public QTestEvent {
+ public:
+  enum Action { Press, Move, Release };
+
+  QTestTouchEvent(Action action, int id, const QPoint& pos)
+      : action_(action), id_(id), pos_(pos) {}
+
+  void simulate(QWidget* w) {
+    switch (action_) {
+      case Press:
+        QTest::touchEvent(w).press(id_, pos_);
+        break;
+      case Move:
+        QTest::touchEvent(w).move(id_, pos_);
+        break;
+      case Release:
+        QTest::touchEvent(w).release(id_, pos_);
+        break;
+    }
+  }
+
+  QTestEvent* clone() const { return new QTestTouchEvent(*this); }
+
+ private:
+  Action action_;
+  int id_;
+  QPoint pos_;
+};
+
 QTestEventListWrap::QTestEventListWrap() {
   q_ = new QTestEventList();
 }
@@ -53,8 +90,26 @@ void QTestEventListWrap::Initialize(Handle<Object> target) {
   // Prototype
   tpl->PrototypeTemplate()->Set(String::NewSymbol("addMouseClick"),
       FunctionTemplate::New(AddMouseClick)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addMousePress"),
+      FunctionTemplate::New(AddMousePress)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addMouseRelease"),
+      FunctionTemplate::New(AddMouseRelease)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addMouseDClick"),
+      FunctionTemplate::New(AddMouseDClick)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addMouseMove"),
+      FunctionTemplate::New(AddMouseMove)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("addKeyPress"),
       FunctionTemplate::New(AddKeyPress)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addKeyRelease"),
+      FunctionTemplate::New(AddKeyRelease)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addTouchPress"),
+      FunctionTemplate::New(AddTouchPress)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addTouchMove"),
+      FunctionTemplate::New(AddTouchMove)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addTouchRelease"),
+      FunctionTemplate::New(AddTouchRelease)->GetFunction());
+  tpl->PrototypeTemplate()->Set(String::NewSymbol("addDelay"),
+      FunctionTemplate::New(AddDelay)->GetFunction());
   tpl->PrototypeTemplate()->Set(String::NewSymbol("simulate"),
       FunctionTemplate::New(Simulate)->GetFunction());
 
@@ -71,13 +126,75 @@ NAN_METHOD(QTestEventListWrap::New) {
   NanReturnValue(args.This());
 }
 
+// Position defaults to the widget's center, as in QTest
+static QPoint MousePos(_NAN_METHOD_ARGS) {
+  if (args.Length() < 4)
+    return QPoint();
+  return QPoint(args[2]->IntegerValue(), args[3]->IntegerValue());
+}
+
+// Supported versions:
+//   addMouseClick(button)
+//   addMouseClick(button, modifiers)
+//   addMouseClick(button, modifiers, x, y)
+// Same for addMousePress(), addMouseRelease() and addMouseDClick()
 NAN_METHOD(QTestEventListWrap::AddMouseClick) {
   NanScope();
 
   QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
   QTestEventList* q = w->GetWrapped();
 
-  q->addMouseClick((Qt::MouseButton)args[0]->IntegerValue());
+  q->addMouseClick((Qt::MouseButton)args[0]->IntegerValue(),
+      (Qt::KeyboardModifiers)args[1]->IntegerValue(), MousePos(args));
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QTestEventListWrap::AddMousePress) {
+  NanScope();
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  q->addMousePress((Qt::MouseButton)args[0]->IntegerValue(),
+      (Qt::KeyboardModifiers)args[1]->IntegerValue(), MousePos(args));
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QTestEventListWrap::AddMouseRelease) {
+  NanScope();
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  q->addMouseRelease((Qt::MouseButton)args[0]->IntegerValue(),
+      (Qt::KeyboardModifiers)args[1]->IntegerValue(), MousePos(args));
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QTestEventListWrap::AddMouseDClick) {
+  NanScope();
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  q->addMouseDClick((Qt::MouseButton)args[0]->IntegerValue(),
+      (Qt::KeyboardModifiers)args[1]->IntegerValue(), MousePos(args));
+
+  NanReturnUndefined();
+}
+
+// QUIRK:
+// QTest moves the real cursor for mouse moves
+NAN_METHOD(QTestEventListWrap::AddMouseMove) {
+  NanScope();
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  q->addMouseMove(QPoint(args[0]->IntegerValue(), args[1]->IntegerValue()));
 
   NanReturnUndefined();
 }
@@ -96,15 +213,100 @@ NAN_METHOD(QTestEventListWrap::AddKeyPress) {
   NanReturnUndefined();
 }
 
+NAN_METHOD(QTestEventListWrap::AddKeyRelease) {
+  NanScope();
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  if (args[0]->IsString())
+    q->addKeyRelease( qt_v8::ToQString(args[0]->ToString())[0].toAscii() );
+  else
+    q->addKeyRelease( (Qt::Key)args[0]->IntegerValue() );
+
+  NanReturnUndefined();
+}
+
+// Supported versions:
+//   addTouchPress(id, x, y)
+// Same for addTouchMove() and addTouchRelease(). Each is a separate touch
+// event on a touch screen; the first press starts the sequence and the
+// last release ends it
+NAN_METHOD(QTestEventListWrap::AddTouchPress) {
+  NanScope();
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  q->append(new QTestTouchEvent(QTestTouchEvent::Press,
+      args[0]->IntegerValue(),
+      QPoint(args[1]->IntegerValue(), args[2]->IntegerValue())));
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QTestEventListWrap::AddTouchMove) {
+  NanScope();
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  q->append(new QTestTouchEvent(QTestTouchEvent::Move,
+      args[0]->IntegerValue(),
+      QPoint(args[1]->IntegerValue(), args[2]->IntegerValue())));
+
+  NanReturnUndefined();
+}
+
+NAN_METHOD(QTestEventListWrap::AddTouchRelease) {
+  NanScope();
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  q->append(new QTestTouchEvent(QTestTouchEvent::Release,
+      args[0]->IntegerValue(),
+      QPoint(args[1]->IntegerValue(), args[2]->IntegerValue())));
+
+  NanReturnUndefined();
+}
+
+// Milliseconds
+NAN_METHOD(QTestEventListWrap::AddDelay) {
+  NanScope();
+
+  QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
+  QTestEventList* q = w->GetWrapped();
+
+  q->addDelay(args[0]->IntegerValue());
+
+  NanReturnUndefined();
+}
+
 NAN_METHOD(QTestEventListWrap::Simulate) {
   NanScope();
 
   QTestEventListWrap* w = ObjectWrap::Unwrap<QTestEventListWrap>(args.This());
   QTestEventList* q = w->GetWrapped();
 
-  QWidgetWrap* widget_wrap = node::ObjectWrap::Unwrap<QWidgetWrap>(
-      args[0]->ToObject());
-  QWidget* widget = widget_wrap->GetWrapped();
+  if (!args[0]->IsObject())
+    return NanThrowTypeError("QTestEventList::simulate: bad arguments");
+
+  QString constructor_name =
+    qt_v8::ToQString(args[0]->ToObject()->GetConstructorName());
+
+  QWidget* widget;
+  if (constructor_name == "QWidget") {
+    widget = node::ObjectWrap::Unwrap<QWidgetWrap>(
+        args[0]->ToObject())->GetWrapped();
+  } else if (constructor_name == "QGraphicsView") {
+    // Scroll areas only take mouse input through their viewport; key events
+    // the viewport ignores still propagate up to the view
+    widget = node::ObjectWrap::Unwrap<QGraphicsViewWrap>(
+        args[0]->ToObject())->GetWrapped()->viewport();
+  } else {
+    return NanThrowTypeError("QTestEventList::simulate: bad arguments");
+  }
 
   q->simulate(widget);
 
@@ -48,7 +48,16 @@ class QTestEventListWrap : public node::ObjectWrap {
 
   // Wrapped methods
   static NAN_METHOD(AddMouseClick);
+  static NAN_METHOD(AddMousePress);
+  static NAN_METHOD(AddMouseRelease);
+  static NAN_METHOD(AddMouseDClick);
+  static NAN_METHOD(AddMouseMove);
   static NAN_METHOD(AddKeyPress);
+  static NAN_METHOD(AddKeyRelease);
+  static NAN_METHOD(AddTouchPress);
+  static NAN_METHOD(AddTouchMove);
+  static NAN_METHOD(AddTouchRelease);
+  static NAN_METHOD(AddDelay);
   static NAN_METHOD(Simulate);
 
   // Wrapped object
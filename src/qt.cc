@@ -37,6 +37,7 @@
 #include "QtGui/qmouseevent.h"
 #include "QtGui/qkeyevent.h"
 #include "QtGui/qpixmap.h"
+#include "QtGui/qpixmapcache.h"
 #include "QtGui/qpainter.h"
 #include "QtGui/qcolor.h"
 #include "QtGui/qbrush.h"
@@ -48,31 +49,98 @@
 #include "QtGui/qsound.h"
 #include "QtGui/qscrollarea.h"
 #include "QtGui/qscrollbar.h"
+#include "QtGui/qpicture.h"
+#include "QtGui/qimagereader.h"
+#include "QtGui/qmovie.h"
+#include "QtGui/qgraphicsitem.h"
+#include "QtGui/qgraphicsscene.h"
+#include "QtGui/qgraphicsview.h"
 
 #include "QtTest/qtesteventlist.h"
 
+#include "Extras/imagestreamwriter.h"
+#include "Extras/imageloader.h"
+#include "Extras/imagepyramid.h"
+#include "Extras/sharedimage.h"
+#include "Extras/inputlog.h"
+#include "Extras/spatialindex.h"
+#include "Extras/framecapture.h"
+
 using namespace v8;
 
+//
+// Classes are registered lazily: the module object only gets an accessor per
+// class, and the FunctionTemplate is built the first time a script reads it.
+// Scripts that only touch a handful of classes (e.g. rasterizing CLI tools)
+// don't pay for the rest at require() time.
+//
+// Native code can still need a class no script has read yet (e.g. the QImage
+// an ImageLoader hands back), so NewInstance() builds the constructor on demand
+// with qt_v8::EnsureConstructor(), and Initialize() starts with
+// qt_v8::HasConstructor() to expose that one instead of building another.
+//
+struct LazyClass {
+  const char* name;
+  void (*initialize)(Handle<Object> target);
+};
+
+static LazyClass classes[] = {
+  { "QApplication", QApplicationWrap::Initialize },
+  { "QWidget", QWidgetWrap::Initialize },
+  { "QSize", QSizeWrap::Initialize },
+  { "QMouseEvent", QMouseEventWrap::Initialize },
+  { "QKeyEvent", QKeyEventWrap::Initialize },
+  { "QTestEventList", QTestEventListWrap::Initialize },
+  { "QPixmap", QPixmapWrap::Initialize },
+  { "QPixmapCache", QPixmapCacheWrap::Initialize },
+  { "QPainter", QPainterWrap::Initialize },
+  { "QColor", QColorWrap::Initialize },
+  { "QBrush", QBrushWrap::Initialize },
+  { "QPen", QPenWrap::Initialize },
+  { "QImage", QImageWrap::Initialize },
+  { "QPointF", QPointFWrap::Initialize },
+  { "QPainterPath", QPainterPathWrap::Initialize },
+  { "QFont", QFontWrap::Initialize },
+  { "QMatrix", QMatrixWrap::Initialize },
+  { "QSound", QSoundWrap::Initialize },
+  { "QScrollArea", QScrollAreaWrap::Initialize },
+  { "QScrollBar", QScrollBarWrap::Initialize },
+  { "QPicture", QPictureWrap::Initialize },
+  { "QImageReader", QImageReaderWrap::Initialize },
+  { "QMovie", QMovieWrap::Initialize },
+  { "QGraphicsItem", QGraphicsItemWrap::Initialize },
+  { "QGraphicsScene", QGraphicsSceneWrap::Initialize },
+  { "QGraphicsView", QGraphicsViewWrap::Initialize },
+  { "ImageStreamWriter", ImageStreamWriter::Initialize },
+  { "ImagePyramid", ImagePyramid::Initialize },
+  { "SharedImage", SharedImage::Initialize },
+  { "ImageLoader", ImageLoader::Initialize },
+  { "InputLog", InputLog::Initialize },
+  { "SpatialIndex", SpatialIndex::Initialize },
+  { "FrameCapture", FrameCapture::Initialize },
+};
+
+//
+// LoadClass()
+// Swaps the accessor for the real constructor and returns it
+//
+static NAN_GETTER(LoadClass) {
+  NanScope();
+
+  LazyClass* c = static_cast<LazyClass*>(External::Unwrap(args.Data()));
+  Local<Object> target = args.Holder();
+
+  target->ForceDelete(property);
+  c->initialize(target);
+
+  NanReturnValue(target->Get(property));
+}
+
 void Initialize(Handle<Object> target) {
-  QApplicationWrap::Initialize(target);
-  QWidgetWrap::Initialize(target);
-  QSizeWrap::Initialize(target);
-  QMouseEventWrap::Initialize(target);
-  QKeyEventWrap::Initialize(target);
-  QTestEventListWrap::Initialize(target);
-  QPixmapWrap::Initialize(target);
-  QPainterWrap::Initialize(target);
-  QColorWrap::Initialize(target);
-  QBrushWrap::Initialize(target);
-  QPenWrap::Initialize(target);
-  QImageWrap::Initialize(target);
-  QPointFWrap::Initialize(target);
-  QPainterPathWrap::Initialize(target);
-  QFontWrap::Initialize(target);
-  QMatrixWrap::Initialize(target);
-  QSoundWrap::Initialize(target);
-  QScrollAreaWrap::Initialize(target);
-  QScrollBarWrap::Initialize(target);
+  for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+    target->SetAccessor(String::NewSymbol(classes[i].name), LoadClass, 0,
+                        External::Wrap(&classes[i]));
+  }
 }
 
 NODE_MODULE(qt, Initialize)
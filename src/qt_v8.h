@@ -31,6 +31,7 @@
 #define QTV8_H
 
 #include <node.h>
+#include <nan.h>
 #include <QString>
 
 namespace qt_v8 {
@@ -43,6 +44,22 @@ inline v8::Local<v8::String> FromQString(QString str) {
   return v8::String::New( str.utf16() );
 }
 
+// Lazily registered classes (see qt.cc): true, after exposing it on target,
+// if the constructor was already built
+inline bool HasConstructor(const v8::Persistent<v8::Function>& constructor,
+                           v8::Handle<v8::Object> target, const char* name) {
+  if (constructor.IsEmpty())
+    return false;
+  target->Set(v8::String::NewSymbol(name), NanPersistentToLocal(constructor));
+  return true;
+}
+
+inline void EnsureConstructor(const v8::Persistent<v8::Function>& constructor,
+                              void (*initialize)(v8::Handle<v8::Object>)) {
+  if (constructor.IsEmpty())
+    initialize(v8::Object::New());
+}
+
 } // namespace
 
 #endif
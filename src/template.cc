@@ -29,6 +29,7 @@
 
 #include <node.h>
 #include "__template__.h"
+#include "../qt_v8.h"
 
 using namespace v8;
 
@@ -45,6 +46,9 @@ __Template__Wrap::~__Template__Wrap() {
 }
 
 void __Template__Wrap::Initialize(Handle<Object> target) {
+  if (qt_v8::HasConstructor(constructor, target, "__Template__"))
+    return;
+
   // Prepare constructor template
   Local<FunctionTemplate> tpl = FunctionTemplate::New(New);
   tpl->SetClassName(String::NewSymbol("__Template__"));
@@ -70,6 +74,8 @@ NAN_METHOD(__Template__Wrap::New) {
 Handle<Value> __Template__Wrap::NewInstance(__Template__ q) {
   NanScope():
 
+  qt_v8::EnsureConstructor(constructor, Initialize);
+
   Local<Object> instance = NanPersistentToLocal(constructor)->NewInstance(0, NULL);
   __Template__Wrap* w = node::ObjectWrap::Unwrap<__Template__Wrap>(instance);
   w->SetWrapped(q);
@@ -0,0 +1,188 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+function pump(ms) {
+  var start = Date.now();
+  while (Date.now() - start < ms)
+    app.processEvents();
+}
+
+// start(), release(), frame contents
+{
+  var widget = new qt.QWidget();
+  widget.resize(40, 30);
+  widget.paintEvent(function() {
+    var p = new qt.QPainter();
+    p.begin(widget);
+    p.fillRect(0, 0, 40, 30, new qt.QColor(255, 0, 0));
+    p.end();
+  });
+
+  var capture = new qt.FrameCapture(widget, 2);
+  var frames = [];
+  capture.start(function(frame) {
+    frames.push(frame);
+  }, true);
+
+  widget.show();
+  pump(100);
+
+  assert.ok(frames.length >= 1, 'a frame per paint');
+  var f = frames[0];
+  assert.equal(f.width, 40);
+  assert.equal(f.height, 30);
+  assert.ok(f.stride >= 160);
+  assert.equal(f.buffer.length, f.stride * 30);
+  assert.equal(f.serial, 0);
+  assert.ok(f.damage.length >= 1);
+
+  // Premultiplied ARGB32, little-endian: B G R A
+  var at = 10 * f.stride + 10 * 4;
+  assert.deepEqual([f.buffer[at], f.buffer[at + 1], f.buffer[at + 2],
+                    f.buffer[at + 3]], [0, 0, 255, 255]);
+
+  // Slots are not reused until released; later frames are dropped
+  for (var i = 0; i < 5; i++) {
+    widget.update();
+    pump(20);
+  }
+  assert.ok(frames.length <= 2);
+  assert.ok(capture.dropped() > 0);
+
+  frames.forEach(function(frame) {
+    capture.release(frame.slot);
+  });
+  frames = [];
+  widget.update();
+  pump(50);
+  assert.ok(frames.length >= 1, 'released slots are reused');
+
+  var flag = false;
+  try {
+    capture.release(5);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'release() should reject unknown slots');
+
+  // One capture per widget
+  flag = false;
+  try {
+    new qt.FrameCapture(widget).start(function() {});
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'start() should refuse a widget that is already captured');
+
+  capture.stop();
+  var count = capture.frameCount();
+  widget.update();
+  pump(50);
+  assert.equal(capture.frameCount(), count, 'no frames after stop()');
+
+  widget.close();
+}
+
+// Offscreen renders are not captured
+{
+  var widget = new qt.QWidget();
+  widget.resize(20, 20);
+  var capture = new qt.FrameCapture(widget);
+  var frames = 0;
+  capture.start(function(frame) {
+    frames++;
+    capture.release(frame.slot);
+  });
+
+  widget.grab();
+  pump(20);
+  assert.equal(frames, 0);
+  capture.stop();
+}
+
+// Stopping from inside the paint callback
+{
+  var widget = new qt.QWidget();
+  widget.resize(20, 20);
+  var capture = new qt.FrameCapture(widget);
+  var frames = 0;
+  widget.paintEvent(function() {
+    capture.stop();
+    capture = null;
+  });
+  capture.start(function() {
+    frames++;
+  });
+
+  widget.show();
+  pump(50);
+  assert.equal(frames, 0, 'no frame is delivered after stop()');
+  widget.close();
+}
+
+// Frames queued but not delivered when stop()ped don't keep their slot
+{
+  var widget = new qt.QWidget();
+  widget.resize(20, 20);
+  var child = new qt.QWidget(widget);
+  child.resize(10, 10);
+
+  // The child paints after its parent's frame was queued
+  var capture = new qt.FrameCapture(widget, 1);
+  var stopInPaint = true;
+  child.paintEvent(function() {
+    if (stopInPaint)
+      capture.stop();
+  });
+  var frames = 0;
+  capture.start(function() {
+    frames++;
+  });
+
+  widget.show();
+  pump(50);
+  assert.equal(frames, 0);
+
+  stopInPaint = false;
+  capture.start(function(frame) {
+    frames++;
+    capture.release(frame.slot);
+  });
+  widget.update();
+  pump(50);
+  assert.ok(frames >= 1, 'frames still arrive after stop() and start()');
+
+  capture.stop();
+  widget.close();
+}
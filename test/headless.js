@@ -0,0 +1,80 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+// Separate file: only one QApplication may exist per process
+var app = new qt.QApplication({ gui: false });
+assert.equal(app.isGui(), false);
+
+// Raster painting, fonts and encoding
+{
+  var image = new qt.QImage(40, 40, qt.ImageFormat.Format_ARGB32_Premultiplied);
+  image.fill(qt.GlobalColor.white);
+
+  var painter = new qt.QPainter();
+  assert.ok(painter.begin(image));
+  painter.setFont(new qt.QFont);
+  painter.fillRect(0, 0, 10, 10, new qt.QColor(255, 0, 0));
+  painter.drawText(0, 30, "hi");
+  assert.ok(painter.end());
+
+  assert.equal(image.pixel(5, 5), 0xffff0000);
+
+  var png = image.toBuffer('png');
+  assert.equal(png.toString('ascii', 1, 4), 'PNG');
+}
+
+// Widgets, pixmaps and movies need a display
+{
+  var flag = false;
+  try {
+    new qt.QWidget();
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'QWidget() should throw without gui');
+
+  flag = false;
+  try {
+    new qt.QPixmap(10, 10);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'QPixmap() should throw without gui');
+
+  flag = false;
+  try {
+    new qt.QMovie('resources/qmovie.gif');
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'QMovie() should throw without gui');
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    fs = require('fs'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+function feed(loader, data, chunkSize) {
+  for (var i = 0; i < data.length; i += chunkSize)
+    loader.write(data.slice(i, Math.min(data.length, i + chunkSize)));
+}
+
+// Chunked PNG
+{
+  var data = fs.readFileSync('resources/qimage.png');
+  var loader = new qt.ImageLoader;
+  var header = null;
+  loader.headerEvent(function(width, height, format) {
+    assert.equal(header, null, 'header callback fires once');
+    header = [width, height, format];
+  });
+
+  loader.write(data.slice(0, 10));
+  assert.equal(header, null);
+  feed(loader, data.slice(10), 100);
+  assert.deepEqual(header, [100, 100, 'png']);
+  assert.equal(loader.bytesReceived(), data.length);
+
+  var image = loader.end();
+  assert.equal(image.width(), 100);
+  assert.equal(loader.bytesReceived(), 0, 'compressed data is released');
+
+  var flag = false;
+  try {
+    loader.write(data);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'write() after end() should throw');
+}
+
+// Partial JPEG decodes
+{
+  var source = new qt.QImage(200, 300, qt.ImageFormat.Format_RGB32);
+  source.fill(qt.GlobalColor.red);
+  var data = source.toBuffer('jpg', 90);
+
+  var loader = new qt.ImageLoader({ partialStep: 64 });
+  var partials = 0;
+  loader.partialEvent(function(image) {
+    assert.equal(image.width(), 200);
+    assert.equal(image.height(), 300);
+    ++partials;
+  });
+  feed(loader, data, 64);
+  assert.ok(partials > 0, 'partial callback should fire for JPEG');
+  assert.equal(loader.end().height(), 300);
+}
+
+// Garbage
+{
+  var loader = new qt.ImageLoader;
+  loader.write(new Buffer('not an image'));
+  var flag = false;
+  try {
+    loader.end();
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'end() should throw on undecodable data');
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+function solid(width, height, color) {
+  var image = new qt.QImage(width, height, qt.ImageFormat.Format_RGB32);
+  image.fill(color);
+  return image;
+}
+
+// Constructor
+{
+  var pyramid = new qt.ImagePyramid(solid(100, 60, qt.GlobalColor.red));
+  assert.ok(pyramid);
+  // 100x60, 50x30, 25x15, 13x8, 7x4, 4x2, 2x1, 1x1
+  assert.equal(pyramid.levelCount(), 8);
+
+  var flag = false;
+  try {
+    new qt.ImagePyramid(new qt.QImage);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'ImagePyramid should reject null images');
+}
+
+// level()
+{
+  var pyramid = new qt.ImagePyramid(solid(100, 60, qt.GlobalColor.red));
+  assert.equal(pyramid.level(0).width(), 100);
+  var level3 = pyramid.level(3);
+  assert.equal(level3.width(), 13);
+  assert.equal(level3.height(), 8);
+  assert.equal(level3.pixel(6, 4), 0xffff0000);
+  assert.equal(pyramid.level(7).width(), 1);
+}
+
+// levelForScale()
+{
+  var pyramid = new qt.ImagePyramid(solid(256, 256, qt.GlobalColor.red));
+  assert.equal(pyramid.levelForScale(1).width(), 256);
+  assert.equal(pyramid.levelForScale(2).width(), 256);
+  assert.equal(pyramid.levelForScale(0.5).width(), 128);
+  assert.equal(pyramid.levelForScale(0.3).width(), 128);
+  assert.equal(pyramid.levelForScale(0.25).width(), 64);
+}
+
+// painter.drawImage() with a pyramid
+{
+  var pyramid = new qt.ImagePyramid(solid(400, 400, qt.GlobalColor.blue));
+  var target = solid(100, 100, qt.GlobalColor.white);
+  var painter = new qt.QPainter;
+  painter.begin(target);
+  painter.setMatrix(new qt.QMatrix(0.25, 0, 0, 0.25, 0, 0));
+  painter.drawImage(0, 0, pyramid);
+  painter.end();
+  assert.equal(target.pixel(50, 50), 0xff0000ff);
+  assert.equal(target.pixel(99, 99), 0xff0000ff);
+}
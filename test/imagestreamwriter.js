@@ -0,0 +1,107 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    fs = require('fs'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+function strip(width, height, color) {
+  var image = new qt.QImage(width, height, qt.ImageFormat.Format_ARGB32);
+  var painter = new qt.QPainter();
+  painter.begin(image);
+  painter.fillRect(0, 0, width, height, color);
+  painter.end();
+  return image;
+}
+
+// PNG to file, strip by strip
+{
+  var file = '__stream.png';
+  var writer = new qt.ImageStreamWriter(file, 40, 30, 'png');
+  writer.write(strip(40, 10, qt.GlobalColor.red));
+  writer.write(strip(40, 20, qt.GlobalColor.blue));
+  assert.equal(writer.rowsWritten(), 30);
+  assert.equal(writer.close(), true);
+
+  var image = new qt.QImage(file);
+  assert.equal(image.isNull(), false);
+  assert.equal(image.width(), 40);
+  assert.equal(image.height(), 30);
+  assert.equal(image.pixel(5, 5), 0xffff0000);
+  assert.equal(image.pixel(5, 25), 0xff0000ff);
+  fs.unlinkSync(file);
+}
+
+// PNG to a sink function
+{
+  var chunks = [];
+  var writer = new qt.ImageStreamWriter(function(buffer) {
+    chunks.push(buffer);
+  }, 10, 10, 'png', { alpha: false, compression: 9 });
+  writer.write(strip(10, 10, qt.GlobalColor.green));
+  assert.equal(writer.close(), true);
+
+  var png = Buffer.concat(chunks);
+  assert.equal(png.toString('ascii', 1, 4), 'PNG');
+  assert.equal(png.toString('ascii', png.length - 8, png.length - 4), 'IEND');
+}
+
+// PPM
+{
+  var chunks = [];
+  var writer = new qt.ImageStreamWriter(function(buffer) {
+    chunks.push(buffer);
+  }, 2, 1, 'ppm');
+  writer.write(strip(2, 1, qt.GlobalColor.red));
+  assert.equal(writer.close(), true);
+
+  var ppm = Buffer.concat(chunks);
+  assert.equal(ppm.toString('ascii', 0, 11), 'P6\n2 1\n255\n');
+  assert.equal(ppm.length, 11 + 2 * 3);
+  assert.equal(ppm[11], 255);
+  assert.equal(ppm[12], 0);
+}
+
+// Incomplete images and bad strips
+{
+  var writer = new qt.ImageStreamWriter(function() {}, 10, 10, 'raw');
+
+  var flag = false;
+  try {
+    writer.write(strip(5, 5, qt.GlobalColor.red));
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'write should throw on width mismatch');
+
+  writer.write(strip(10, 5, qt.GlobalColor.red));
+  assert.equal(writer.close(), false);
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+// record(), stop(), toBuffer()
+var widget = new qt.QWidget;
+widget.resize(100, 100);
+
+var log = new qt.InputLog;
+log.record(widget);
+
+var events = new qt.QTestEventList();
+events.addMouseClick(qt.MouseButton.LeftButton, 0, 10, 20); // press, release
+// Past 16-bit coordinates, as on large high-DPI widgets
+events.addMouseClick(qt.MouseButton.LeftButton, 0, 40000, 70000);
+events.addKeyPress('a');
+events.addKeyRelease('a');
+events.simulate(widget);
+log.stop();
+
+// Not recorded
+events.simulate(widget);
+
+assert.equal(log.count(), 6);
+assert.ok(log.duration() >= 0);
+
+var copy = new qt.InputLog(log.toBuffer());
+assert.equal(copy.count(), 6);
+
+var flag = false;
+try {
+  new qt.InputLog(new Buffer('not a log'));
+} catch (e) {
+  flag = true;
+}
+assert.ok(flag, 'InputLog() should throw on bad data');
+
+// A header claiming far more events than the buffer holds
+var truncated = log.toBuffer().slice(0, 10);
+truncated.writeUInt32LE(0xffffffff, 6);
+flag = false;
+try {
+  new qt.InputLog(truncated);
+} catch (e) {
+  flag = true;
+}
+assert.ok(flag, 'InputLog() should throw on truncated logs');
+
+// replay()
+{
+  var presses = [], keys = [];
+  widget.mousePressEvent(function(e) {
+    presses.push([e.x(), e.y()]);
+  });
+  widget.keyPressEvent(function(e) {
+    keys.push(e.text());
+  });
+
+  var stats = null;
+  copy.replay(widget, { speed: 0 }, function(err, result) {
+    assert.ifError(err);
+    stats = result;
+  });
+
+  flag = false;
+  try {
+    copy.replay(widget, function() {});
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'replay() should throw while a replay is running');
+
+  var timer = setInterval(function() {
+    app.processEvents();
+    if (!stats)
+      return;
+
+    clearInterval(timer);
+    assert.deepEqual(presses, [[10, 20], [40000, 70000]]);
+    assert.deepEqual(keys, ['a']);
+    assert.equal(stats.count, 6);
+    assert.equal(stats.latencies.length, 6);
+    assert.ok(stats.max >= stats.mean);
+  }, 10);
+
+  process.on('exit', function() {
+    assert.ok(stats, 'replay() callback should run');
+  });
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+// Lazily registered classes and enums are still enumerable
+{
+  var keys = Object.keys(qt);
+  ['QApplication', 'QWidget', 'QImage', 'QPainter', 'ImageLoader',
+   'ImageFormat', 'Key'].forEach(function(name) {
+    assert.ok(keys.indexOf(name) >= 0, name + ' should be listed');
+  });
+}
+
+var app = new qt.QApplication();
+
+// Native code creating a class before any script touched it
+{
+  var image = new qt.QImageReader('resources/qimage.png').read();
+  assert.equal(image.width(), 100);
+  assert.ok(image instanceof qt.QImage,
+            'instances made natively share the exported constructor');
+  assert.strictEqual(qt.QImage, qt.QImage);
+}
+
+// Enums are frozen on first read
+{
+  assert.ok(Object.isFrozen(qt.ImageFormat));
+  assert.strictEqual(qt.ImageFormat, qt.ImageFormat);
+  qt.ImageFormat = null;
+  assert.equal(qt.ImageFormat.Format_RGB32, 4);
+}
@@ -0,0 +1,243 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+// addXxx(), itemCount()
+{
+  var scene = new qt.QGraphicsScene(0, 0, 200, 200);
+  var red = new qt.QBrush(qt.GlobalColor.red);
+
+  var rect = scene.addRect(10, 10, 50, 50, new qt.QPen(red, 1), red);
+  assert.equal(rect.type(), 3);
+
+  var path = new qt.QPainterPath();
+  path.moveTo(new qt.QPointF(100, 100));
+  path.lineTo(new qt.QPointF(150, 100));
+  path.lineTo(new qt.QPointF(150, 150));
+  path.closeSubpath();
+  var triangle = scene.addPath(path);
+  assert.equal(triangle.type(), 2);
+
+  var image = new qt.QImage(20, 20, qt.ImageFormat.Format_RGB32);
+  var picture = scene.addPixmap(image);
+  picture.setPos(170, 10);
+  assert.equal(picture.x(), 170);
+
+  var label = scene.addSimpleText('hello', new qt.QFont);
+  assert.equal(label.type(), 9);
+
+  assert.equal(scene.itemCount(), 4);
+
+  var flag = false;
+  try {
+    scene.addPath('nope');
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'addPath() should throw without a QPainterPath');
+}
+
+// itemsAt(), items()
+{
+  var scene = new qt.QGraphicsScene(0, 0, 1000, 1000);
+  var items = [];
+  for (var i = 0; i < 100; i++)
+    items.push(scene.addRect(i * 10, 0, 10, 10));
+
+  var hit = scene.itemsAt(55, 5);
+  assert.equal(hit.length, 1);
+  assert.strictEqual(hit[0], items[5], 'hit tests return the same wrappers');
+
+  // Topmost first
+  var top = scene.addRect(50, 0, 10, 10);
+  top.setZValue(1);
+  hit = scene.itemsAt(55, 5);
+  assert.equal(hit.length, 2);
+  assert.strictEqual(hit[0], top);
+
+  assert.equal(scene.items(0, 0, 30, 10).length, 3);
+  assert.equal(scene.itemsAt(500, 500).length, 0);
+
+  // removeItem()
+  scene.removeItem(top);
+  assert.equal(scene.itemsAt(55, 5).length, 1);
+  flag = false;
+  try {
+    top.x();
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'removed items should throw');
+
+  scene.clear();
+  assert.equal(scene.itemCount(), 0);
+}
+
+// render()
+{
+  var scene = new qt.QGraphicsScene(0, 0, 20, 20);
+  var blue = new qt.QBrush(qt.GlobalColor.blue);
+  scene.addRect(0, 0, 20, 20, new qt.QPen(blue, 0), blue);
+
+  var image = new qt.QImage(20, 20, qt.ImageFormat.Format_RGB32);
+  image.fill(qt.GlobalColor.white);
+  scene.render(image);
+  assert.equal(image.pixel(10, 10), 0xff0000ff);
+}
+
+// QGraphicsView
+{
+  var scene = new qt.QGraphicsScene(0, 0, 100, 100);
+  var item = scene.addRect(0, 0, 100, 100);
+  var view = new qt.QGraphicsView(scene);
+  view.resize(150, 150);
+  view.show();
+  app.processEvents();
+
+  var pressed = null;
+  view.mousePressEvent(function(e) {
+    pressed = view.itemsAt(e.x(), e.y());
+  });
+
+  var events = new qt.QTestEventList();
+  events.addMouseClick(qt.MouseButton.LeftButton);
+  events.simulate(view);
+  app.processEvents();
+  assert.equal(pressed.length, 1);
+  assert.strictEqual(pressed[0], item);
+
+  view.close();
+}
+
+// setCacheMode(), cacheStats(), QPixmapCache
+{
+  var limit = qt.QPixmapCache.cacheLimit();
+  qt.QPixmapCache.setCacheLimit(20480);
+  assert.equal(qt.QPixmapCache.cacheLimit(), 20480);
+
+  var scene = new qt.QGraphicsScene(0, 0, 1000, 1000);
+  var item = scene.addSimpleText('cached');
+  var uncached = scene.addSimpleText('uncached');
+  uncached.setPos(0, 40);
+  assert.equal(item.cacheMode(), qt.CacheMode.NoCache);
+  item.setCacheMode(qt.CacheMode.DeviceCoordinateCache);
+  assert.equal(item.cacheMode(), qt.CacheMode.DeviceCoordinateCache);
+
+  var flag = false;
+  try {
+    item.setCacheMode(7);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'setCacheMode() should reject unknown modes');
+
+  var view = new qt.QGraphicsView(scene);
+  view.resize(150, 150);
+  view.show();
+  app.processEvents();
+
+  // Pans and moves only translate the item, so its device cache is reused
+  item.resetCacheStats();
+  uncached.resetCacheStats();
+  for (var i = 0; i < 5; i++) {
+    view.centerOn(75 + i * 3, 75);
+    item.setPos(i * 7, 0);
+    uncached.setPos(i * 7, 40);
+    app.processEvents();
+  }
+
+  var stats = item.cacheStats();
+  assert.ok(stats.draws > 0);
+  assert.ok(stats.hits > 0, 'the cached item is drawn from its cache');
+  assert.ok(stats.misses < stats.draws);
+
+  stats = uncached.cacheStats();
+  assert.ok(stats.paints > 0);
+  assert.equal(stats.misses, 0);
+  assert.equal(stats.hits, 0, 'NoCache items report no hits');
+
+  view.close();
+  qt.QPixmapCache.setCacheLimit(limit);
+}
+
+// animate(), stopAnimations(), isAnimating()
+{
+  var scene = new qt.QGraphicsScene(0, 0, 100, 100);
+  var item = scene.addRect(0, 0, 10, 10);
+
+  item.animate('x', 100, 50, qt.EasingCurve.OutCubic);
+  item.animate('rotation', [[0, 0], [0.5, 180], [1, 90]], 50);
+  item.animate('opacity', [[0, 1], [1, 0]], 20, qt.EasingCurve.Linear, -1);
+  assert.ok(item.isAnimating());
+
+  var flag = false;
+  try {
+    item.animate('width', 10, 100);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'animate() should reject unknown properties');
+
+  flag = false;
+  try {
+    item.animate('x', [[0.5, 0], [0.2, 1]], 100);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'animate() should reject unordered keyframes');
+
+  flag = false;
+  try {
+    item.animate('x', [[0.2, 0], [0.8, 1]], 100);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'animate() should reject keyframes not spanning 0 to 1');
+
+  // Frames are ticked by the event loop alone, without JS callbacks
+  var start = Date.now();
+  while (Date.now() - start < 200)
+    app.processEvents();
+
+  assert.equal(item.x(), 100);
+  assert.equal(item.rotation(), 90);
+  assert.ok(item.isAnimating(), 'looping animations keep running');
+
+  item.stopAnimations('opacity');
+  assert.ok(!item.isAnimating());
+
+  // Removing an item cancels its animations
+  item.animate('y', 50, 1000);
+  scene.removeItem(item);
+  app.processEvents();
+}
@@ -28,6 +28,7 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 var assert = require('assert'),
+    fs = require('fs'),
     qt = require('..');
 
 var app = new qt.QApplication();
@@ -50,3 +51,279 @@ var app = new qt.QApplication();
   var image = new qt.QImage('BAD-FILE');
   assert.equal(image.isNull(), true);
 }
+
+// Constructor- size and format
+{
+  var image = new qt.QImage(30, 20, qt.ImageFormat.Format_ARGB32);
+  assert.equal(image.isNull(), false);
+  assert.equal(image.width(), 30);
+  assert.equal(image.height(), 20);
+  assert.equal(image.format(), qt.ImageFormat.Format_ARGB32);
+}
+
+// Constructor- size, default format
+{
+  var image = new qt.QImage(10, 10);
+  assert.equal(image.format(), qt.ImageFormat.Format_ARGB32_Premultiplied);
+}
+
+// pixel()
+{
+  var image = new qt.QImage(10, 10, qt.ImageFormat.Format_RGB32);
+  var painter = new qt.QPainter();
+  assert.equal(painter.begin(image), true);
+  painter.fillRect(0, 0, 10, 10, qt.GlobalColor.red);
+  painter.end();
+  assert.equal(image.pixel(5, 5), 0xffff0000);
+
+  var flag = false;
+  try {
+    image.pixel(10, 10);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'pixel() should throw out of range');
+}
+
+// saveRaw(), loadRaw()
+{
+  var image = new qt.QImage(10, 10, qt.ImageFormat.Format_ARGB32);
+  var painter = new qt.QPainter();
+  painter.begin(image);
+  painter.fillRect(0, 0, 10, 10, qt.GlobalColor.red);
+  painter.fillRect(2, 3, 4, 5, qt.GlobalColor.blue);
+  painter.end();
+  image.saveRaw('__qimage.qraw');
+
+  var mapped = new qt.QImage;
+  mapped.loadRaw('__qimage.qraw');
+  assert.equal(mapped.width(), 10);
+  assert.equal(mapped.height(), 10);
+  assert.equal(mapped.format(), qt.ImageFormat.Format_ARGB32_Premultiplied);
+  assert.equal(mapped.pixel(0, 0), 0xffff0000);
+  assert.equal(mapped.pixel(3, 4), 0xff0000ff);
+
+  // Same file maps to the same pages
+  var again = new qt.QImage;
+  again.loadRaw('__qimage.qraw');
+  assert.equal(again.pixel(3, 4), 0xff0000ff);
+
+  // Replaced on disk (as by another process's saveRaw()): mapped again
+  var green = new qt.QImage(10, 10, qt.ImageFormat.Format_RGB32);
+  green.fill(qt.GlobalColor.green);
+  green.saveRaw('__qimage2.qraw');
+  fs.renameSync('__qimage2.qraw', '__qimage.qraw');
+  var replaced = new qt.QImage;
+  replaced.loadRaw('__qimage.qraw');
+  assert.equal(replaced.pixel(3, 4), 0xff00ff00);
+  assert.equal(mapped.pixel(3, 4), 0xff0000ff, 'old mappings stay valid');
+
+  var flag = false;
+  try {
+    mapped.loadRaw('resources/qimage.png');
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'loadRaw() should throw on non-raw files');
+
+  fs.unlinkSync('__qimage.qraw');
+}
+
+// Constructor- Buffer
+{
+  var data = new Buffer(2 * 2 * 4);
+  data.fill(0);
+  data.writeUInt32LE(0xff00ff00, 4);   // (1, 0) opaque green, BGRA in memory
+  var image = new qt.QImage(data, 2, 2, qt.ImageFormat.Format_ARGB32);
+  assert.equal(image.isNull(), false);
+  assert.equal(image.pixel(1, 0), 0xff00ff00);
+  assert.equal(image.pixel(0, 0), 0);
+
+  var short = new qt.QImage(new Buffer(4), 2, 2, qt.ImageFormat.Format_ARGB32);
+  assert.equal(short.isNull(), true);
+}
+
+// convertToFormat(), premultiply(), unpremultiply()
+{
+  var image = new qt.QImage(4, 4, qt.ImageFormat.Format_ARGB32);
+  image.fill(qt.GlobalColor.red);
+  var rgb = image.convertToFormat(qt.ImageFormat.Format_RGB32);
+  assert.equal(rgb.format(), qt.ImageFormat.Format_RGB32);
+  assert.equal(image.format(), qt.ImageFormat.Format_ARGB32);
+
+  image.premultiply();
+  assert.equal(image.format(), qt.ImageFormat.Format_ARGB32_Premultiplied);
+  image.unpremultiply();
+  assert.equal(image.format(), qt.ImageFormat.Format_ARGB32);
+  assert.equal(image.pixel(0, 0), 0xffff0000);
+}
+
+// rgbSwapped(), fill()
+{
+  var image = new qt.QImage(4, 4, qt.ImageFormat.Format_RGB32);
+  image.fill(new qt.QColor(255, 0, 0));
+  assert.equal(image.pixel(2, 2), 0xffff0000);
+  assert.equal(image.rgbSwapped().pixel(2, 2), 0xff0000ff);
+}
+
+// blend()
+{
+  var dest = new qt.QImage(4, 4, qt.ImageFormat.Format_RGB32);
+  dest.fill(qt.GlobalColor.black);
+  var source = new qt.QImage(2, 2, qt.ImageFormat.Format_ARGB32);
+  source.fill(qt.GlobalColor.white);
+  dest.blend(source, 1, 1);
+  assert.equal(dest.pixel(0, 0), 0xff000000);
+  assert.equal(dest.pixel(1, 1), 0xffffffff);
+
+  dest.fill(qt.GlobalColor.black);
+  dest.blend(source, 0, 0, 0.5);
+  var gray = dest.pixel(0, 0) & 0xff;
+  assert.ok(gray > 120 && gray < 135);
+}
+
+// colorMatrix()
+{
+  var image = new qt.QImage(3, 3, qt.ImageFormat.Format_ARGB32);
+  image.fill(new qt.QColor(255, 0, 0));
+
+  // Swap red and green, add 0.2 to blue
+  image.colorMatrix([0, 1, 0, 0, 0,
+                     1, 0, 0, 0, 0,
+                     0, 0, 1, 0, 0.2,
+                     0, 0, 0, 1, 0]);
+  assert.equal(image.pixel(1, 1), 0xff00ff33);
+  assert.equal(image.format(), qt.ImageFormat.Format_ARGB32);
+
+  var flag = false;
+  try {
+    image.colorMatrix([1, 0, 0]);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'colorMatrix() should throw on short matrices');
+}
+
+// scaled()
+{
+  var image = new qt.QImage(64, 48, qt.ImageFormat.Format_RGB32);
+  image.fill(qt.GlobalColor.red);
+
+  [qt.ResampleFilter.Box, qt.ResampleFilter.Bilinear,
+   qt.ResampleFilter.Lanczos].forEach(function(filter) {
+    var small = image.scaled(16, 12, filter);
+    assert.equal(small.width(), 16);
+    assert.equal(small.height(), 12);
+    assert.equal(small.format(), qt.ImageFormat.Format_RGB32);
+    assert.equal(small.pixel(8, 6), 0xffff0000);
+
+    var large = image.scaled(100, 90, filter);
+    assert.equal(large.pixel(99, 89), 0xffff0000);
+  });
+
+  // Default filter
+  assert.equal(image.scaled(10, 10).width(), 10);
+
+  var flag = false;
+  try {
+    image.scaled(10, 10, 42);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'scaled() should throw on unknown filters');
+}
+
+// scaledAsync()
+{
+  var image = new qt.QImage(200, 100, qt.ImageFormat.Format_ARGB32);
+  image.fill(qt.GlobalColor.blue);
+
+  var called = false;
+  image.scaledAsync(50, 25, qt.ResampleFilter.Lanczos, function(err, small) {
+    assert.ifError(err);
+    assert.equal(small.width(), 50);
+    assert.equal(small.pixel(25, 12), 0xff0000ff);
+    called = true;
+  });
+
+  process.on('exit', function() {
+    assert.ok(called, 'scaledAsync() callback should run');
+  });
+}
+
+// save() with PNG options - every filter, single and multi-threaded,
+// must decode back to the same pixels
+{
+  var image = new qt.QImage(300, 500, qt.ImageFormat.Format_ARGB32);
+  image.fill(qt.GlobalColor.transparent);
+  var painter = new qt.QPainter();
+  painter.begin(image);
+  painter.fillRect(10, 10, 200, 300, qt.GlobalColor.red);
+  painter.fillRect(100, 200, 150, 280, new qt.QColor(0, 0, 255, 128));
+  painter.end();
+
+  ['none', 'sub', 'up', 'average', 'paeth', 'adaptive'].forEach(function(f) {
+    [1, 4].forEach(function(threads) {
+      var file = '__qimage-' + f + '-' + threads + '.png';
+      assert.equal(image.save(file, { filter: f, threads: threads }), true);
+      var copy = new qt.QImage(file);
+      assert.equal(copy.width(), 300);
+      [[0, 0], [50, 50], [150, 250], [299, 499], [120, 400]].forEach(
+          function(p) {
+        assert.equal(copy.pixel(p[0], p[1]), image.pixel(p[0], p[1]),
+                     f + '/' + threads + ' at ' + p);
+      });
+      fs.unlinkSync(file);
+    });
+  });
+
+  var flag = false;
+  try {
+    image.save('__qimage-bad.png', { filter: 'bogus' });
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'save() should throw on unknown filters');
+}
+
+// saveAsync()
+{
+  var image = new qt.QImage(64, 64, qt.ImageFormat.Format_RGB32);
+  image.fill(qt.GlobalColor.green);
+
+  var called = false;
+  image.saveAsync('__qimage-async.png', { compression: 9 }, function(err) {
+    assert.ifError(err);
+    assert.equal(new qt.QImage('__qimage-async.png').pixel(1, 1),
+                 image.pixel(1, 1));
+    fs.unlinkSync('__qimage-async.png');
+    called = true;
+  });
+
+  process.on('exit', function() {
+    assert.ok(called, 'saveAsync() callback should run');
+  });
+}
+
+// toBuffer(), toBufferAsync()
+{
+  var image = new qt.QImage(16, 16, qt.ImageFormat.Format_RGB32);
+  image.fill(qt.GlobalColor.blue);
+
+  var png = image.toBuffer('png');
+  assert.equal(png.toString('ascii', 1, 4), 'PNG');
+  fs.writeFileSync('__qimage-buffer.png', png);
+  assert.equal(new qt.QImage('__qimage-buffer.png').pixel(8, 8), 0xff0000ff);
+  fs.unlinkSync('__qimage-buffer.png');
+
+  var called = false;
+  image.toBufferAsync(function(err, buffer) {
+    assert.ifError(err);
+    assert.ok(buffer.length > 0);
+    called = true;
+  });
+
+  process.on('exit', function() {
+    assert.ok(called, 'toBufferAsync() callback should run');
+  });
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+// Probing - size and format come from the header only
+{
+  var reader = new qt.QImageReader(__dirname + '/resources/qimage.png');
+  assert.equal(reader.canRead(), true);
+  assert.equal(reader.format(), 'png');
+  assert.equal(reader.size().width(), 100);
+  assert.equal(reader.size().height(), 100);
+}
+
+// read()
+{
+  var reader = new qt.QImageReader(__dirname + '/resources/qimage.png');
+  var image = reader.read();
+  assert.equal(image.width(), 100);
+  assert.equal(image.height(), 100);
+}
+
+// setScaledSize()
+{
+  var reader = new qt.QImageReader(__dirname + '/resources/qimage.png');
+  reader.setScaledSize(25, 20);
+  assert.equal(reader.scaledSize().width(), 25);
+  var image = reader.read();
+  assert.equal(image.width(), 25);
+  assert.equal(image.height(), 20);
+}
+
+// setClipRect()
+{
+  var reader = new qt.QImageReader(__dirname + '/resources/qimage.png');
+  reader.setClipRect(10, 10, 30, 40);
+  var image = reader.read();
+  assert.equal(image.width(), 30);
+  assert.equal(image.height(), 40);
+}
+
+// setScaledClipRect()
+{
+  var reader = new qt.QImageReader(__dirname + '/resources/qimage.png');
+  reader.setScaledSize(50, 50);
+  reader.setScaledClipRect(0, 0, 16, 8);
+  var image = reader.read();
+  assert.equal(image.width(), 16);
+  assert.equal(image.height(), 8);
+}
+
+// Errors
+{
+  var reader = new qt.QImageReader(__dirname + '/resources/missing.png');
+  assert.equal(reader.canRead(), false);
+  assert.equal(reader.read().width(), 0);
+  assert.ok(reader.errorString().length > 0);
+}
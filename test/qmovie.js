@@ -0,0 +1,115 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+// QMovie()
+{
+  var movie = new qt.QMovie('resources/qmovie.gif');
+  assert.ok(movie.isValid());
+  assert.equal(movie.frameCount(), 3);
+  assert.equal(movie.currentFrameNumber(), -1);
+
+  var flag = false;
+  try {
+    new qt.QMovie();
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'QMovie() without a file name should throw');
+}
+
+// jumpToFrame()
+{
+  var movie = new qt.QMovie('resources/qmovie.gif');
+
+  assert.ok(movie.jumpToFrame(1));
+  assert.equal(movie.currentFrameNumber(), 1);
+  var image = movie.currentImage();
+  assert.equal(image.width(), 8);
+  assert.equal(image.pixel(0, 0), 0xff0000ff);
+  assert.equal(image.pixel(7, 7), 0xffff0000);
+
+  assert.ok(movie.jumpToFrame(2));
+  image = movie.currentImage();
+  assert.equal(image.pixel(0, 0), 0xff0000ff);
+  assert.equal(image.pixel(7, 7), 0xff00ff00);
+
+  // Backwards through the cache
+  assert.ok(movie.jumpToFrame(0));
+  assert.equal(movie.currentImage().pixel(0, 0), 0xffff0000);
+}
+
+// start(), setPaused(), stop()
+{
+  var movie = new qt.QMovie('resources/qmovie.gif');
+  assert.equal(movie.state(), 0);
+  movie.start();
+  assert.equal(movie.state(), 2);
+  movie.setPaused(true);
+  assert.equal(movie.state(), 1);
+  movie.setPaused(false);
+  assert.equal(movie.state(), 2);
+  movie.stop();
+  assert.equal(movie.state(), 0);
+}
+
+// setSpeed(), setCacheSize()
+{
+  var movie = new qt.QMovie('resources/qmovie.gif');
+  assert.equal(movie.speed(), 100);
+  movie.setSpeed(200);
+  assert.equal(movie.speed(), 200);
+
+  assert.equal(movie.cacheSize(), 16);
+  movie.setCacheSize(2);
+  assert.equal(movie.cacheSize(), 2);
+}
+
+// QWidget addMovie(), removeMovie()
+{
+  var widget = new qt.QWidget();
+  var movie = new qt.QMovie('resources/qmovie.gif');
+  widget.addMovie(movie, 10, 10);
+  movie.start();
+  app.processEvents();
+  widget.removeMovie(movie);
+  movie.stop();
+
+  var flag = false;
+  try {
+    widget.addMovie({}, 0, 0);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'addMovie() with a non-QMovie should throw');
+}
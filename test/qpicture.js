@@ -0,0 +1,139 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+// Constructor
+{
+  var picture = new qt.QPicture;
+  assert.ok(picture);
+  assert.equal(picture.isNull(), true);
+}
+
+// Recording
+{
+  var picture = new qt.QPicture;
+  var painter = new qt.QPainter;
+  assert.equal(painter.begin(picture), true);
+  painter.fillRect(0, 0, 10, 10, qt.GlobalColor.red);
+  painter.end();
+  assert.equal(picture.isNull(), false);
+  assert.ok(picture.size() > 0);
+}
+
+// play()
+{
+  var picture = new qt.QPicture;
+  var painter = new qt.QPainter;
+  painter.begin(picture);
+  painter.fillRect(0, 0, 10, 10, qt.GlobalColor.red);
+  painter.end();
+
+  var image = new qt.QImage(10, 10, qt.ImageFormat.Format_RGB32);
+  painter.begin(image);
+  assert.equal(picture.play(painter), true);
+  painter.end();
+  assert.equal(image.pixel(5, 5), 0xffff0000);
+}
+
+// renderTiled() - tiles must agree with each other at their seams
+{
+  var picture = new qt.QPicture;
+  var painter = new qt.QPainter;
+  painter.begin(picture);
+  painter.fillRect(0, 0, 300, 300, qt.GlobalColor.white);
+  painter.fillRect(50, 50, 100, 200, qt.GlobalColor.red);
+  painter.fillRect(150, 50, 100, 200, qt.GlobalColor.blue);
+  painter.end();
+
+  var image = new qt.QImage(300, 300, qt.ImageFormat.Format_RGB32);
+  picture.renderTiled(image, 64);
+
+  assert.equal(image.pixel(10, 10), 0xffffffff);
+  assert.equal(image.pixel(60, 60), 0xffff0000);
+  assert.equal(image.pixel(127, 128), 0xffff0000); // tile corner
+  assert.equal(image.pixel(149, 249), 0xffff0000);
+  assert.equal(image.pixel(150, 50), 0xff0000ff);
+  assert.equal(image.pixel(249, 249), 0xff0000ff);
+  assert.equal(image.pixel(299, 299), 0xffffffff);
+}
+
+// renderTiled() - pictures with pixmaps can't replay off the GUI thread
+{
+  var pixmap = new qt.QPixmap(10, 10);
+  pixmap.fill(new qt.QColor(255, 0, 0));
+
+  var picture = new qt.QPicture;
+  var painter = new qt.QPainter;
+  painter.begin(picture);
+  painter.drawPixmap(0, 0, pixmap);
+  painter.end();
+
+  var flag = false;
+  try {
+    picture.renderTiled(new qt.QImage(20, 20, qt.ImageFormat.Format_RGB32));
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'renderTiled should throw on pictures with pixmaps');
+
+  picture = new qt.QPicture;
+  painter.begin(picture);
+  var image = new qt.QImage(10, 10, qt.ImageFormat.Format_RGB32);
+  image.fill(qt.GlobalColor.red);
+  painter.drawImage(0, 0, image);
+  painter.end();
+
+  var target = new qt.QImage(20, 20, qt.ImageFormat.Format_RGB32);
+  picture.renderTiled(target, 8);
+  assert.equal(target.pixel(5, 5), 0xffff0000);
+}
+
+// renderTiled() - wrong args
+{
+  var picture = new qt.QPicture;
+  var flag = false;
+  try {
+    picture.renderTiled(new qt.QImage(10, 10, qt.ImageFormat.Format_RGB16));
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'renderTiled should throw on non 32-bit images');
+
+  flag = false;
+  try {
+    picture.renderTiled(1);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'renderTiled should throw with bad args');
+}
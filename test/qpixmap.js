@@ -52,6 +52,61 @@ var app = new qt.QApplication();
   fs.unlinkSync('./__pixmap.png');
 }
 
+// save() with PNG options, saveAsync()
+{
+  var pixmap = new qt.QPixmap(40, 30);
+  pixmap.fill(new qt.QColor(0, 255, 0));
+  assert.equal(pixmap.save('__pixmap-opts.png',
+      { compression: 1, filter: 'paeth', threads: 2 }), true);
+  assert.equal(new qt.QImage('__pixmap-opts.png').pixel(20, 15), 0xff00ff00);
+  fs.unlinkSync('./__pixmap-opts.png');
+
+  var called = false;
+  pixmap.saveAsync('__pixmap-async.png', function(err) {
+    assert.ifError(err);
+    assert.equal(new qt.QImage('__pixmap-async.png').width(), 40);
+    fs.unlinkSync('./__pixmap-async.png');
+    called = true;
+  });
+
+  process.on('exit', function() {
+    assert.ok(called, 'saveAsync() callback should run');
+  });
+}
+
+// toBuffer(), toBufferAsync()
+{
+  var pixmap = new qt.QPixmap(20, 10);
+  pixmap.fill(new qt.QColor(255, 0, 0));
+
+  var png = pixmap.toBuffer();
+  assert.ok(Buffer.isBuffer(png));
+  assert.equal(png.toString('ascii', 1, 4), 'PNG');
+
+  var jpeg = pixmap.toBuffer('jpg', 50);
+  assert.equal(jpeg[0], 0xff);
+  assert.equal(jpeg[1], 0xd8);
+
+  var called = false;
+  pixmap.toBufferAsync('png', function(err, buffer) {
+    assert.ifError(err);
+    assert.equal(buffer.toString('ascii', 1, 4), 'PNG');
+    called = true;
+  });
+
+  var flag = false;
+  try {
+    pixmap.toBuffer('no-such-format');
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'toBuffer() should throw on unknown formats');
+
+  process.on('exit', function() {
+    assert.ok(called, 'toBufferAsync() callback should run');
+  });
+}
+
 // Bitmap regressions
 {
   var pixmap = new qt.QPixmap(100, 100);
@@ -130,3 +130,255 @@ var app = new qt.QApplication();
   assert.equal(capturedEvents[4].text(), 'a'); // keypress
   assert.equal(capturedEvents[5].key(), qt.Key.Key_Left); // keypress
 }
+
+// on(), off()
+{
+  var widget = new qt.QWidget;
+  var resizes = [], presses = 0;
+
+  widget.on(qt.EventType.Resize, function(e) {
+    assert.equal(e.type, qt.EventType.Resize);
+    resizes.push([e.width, e.height]);
+  });
+  widget.on(qt.EventType.MouseButtonPress, function(e) {
+    assert.equal(e.button(), qt.MouseButton.LeftButton);
+    presses++;
+  });
+
+  widget.show();
+  widget.resize(120, 80);
+  app.processEvents();
+  assert.deepEqual(resizes[resizes.length - 1], [120, 80]);
+
+  var events = new qt.QTestEventList();
+  events.addMouseClick(qt.MouseButton.LeftButton);
+  events.simulate(widget);
+  app.processEvents();
+  assert.equal(presses, 1);
+
+  // Unsubscribed types don't reach JS
+  widget.off(qt.EventType.MouseButtonPress);
+  events.simulate(widget);
+  app.processEvents();
+  assert.equal(presses, 1);
+
+  // The shorthand setters share the same table
+  widget.mousePressEvent(function() { presses++; });
+  events.simulate(widget);
+  app.processEvents();
+  assert.equal(presses, 2);
+  widget.off(qt.EventType.MouseButtonPress);
+
+  var flag = false;
+  try {
+    widget.on(qt.EventType.Resize, 'nope');
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'on() should throw without a callback');
+
+  flag = false;
+  try {
+    widget.on(5000, function() {});
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'on() should throw on out-of-range types');
+
+  widget.close();
+}
+
+// on() with plain key events
+{
+  var widget = new qt.QWidget;
+  var keys = [];
+
+  widget.on(qt.EventType.KeyPress, function(e) {
+    keys.push(e);
+  }, { plain: true });
+
+  widget.show();
+  var events = new qt.QTestEventList();
+  events.addKeyPress('a');
+  events.addKeyPress(qt.Key.Key_Left);
+  events.simulate(widget);
+  app.processEvents();
+
+  assert.equal(keys.length, 2);
+  assert.equal(keys[0].text, 'a');
+  assert.equal(keys[0].autoRepeat, false);
+  assert.equal(keys[1].key, qt.Key.Key_Left);
+  assert.equal(keys[1].modifiers, 0);
+  assert.ok(keys[1].timestamp > 0);
+
+  widget.close();
+}
+
+// on() - touch sequences, without batching or a TouchBegin callback
+{
+  var widget = new qt.QWidget;
+  widget.resize(100, 100);
+  var types = [];
+  widget.on(qt.EventType.TouchUpdate, function(e) {
+    types.push(e.type);
+  });
+  widget.on(qt.EventType.TouchEnd, function(e) {
+    types.push(e.type);
+  });
+
+  widget.show();
+  var events = new qt.QTestEventList();
+  events.addTouchPress(0, 10, 10);
+  events.addTouchMove(0, 20, 20);
+  events.addTouchMove(0, 30, 30);
+  events.addTouchRelease(0, 30, 30);
+  events.simulate(widget);
+  app.processEvents();
+
+  assert.deepEqual(types, [qt.EventType.TouchUpdate, qt.EventType.TouchUpdate,
+                           qt.EventType.TouchEnd]);
+  widget.close();
+}
+
+// inputEvents()
+{
+  var widget = new qt.QWidget;
+  var batches = 0;
+
+  widget.inputEvents([qt.EventType.Wheel, qt.EventType.MouseMove,
+                      qt.EventType.TouchBegin], function(records, count) {
+    assert.ok(count > 0, 'empty batches are not delivered');
+    assert.equal(typeof records[qt.InputRecord.Type], 'number');
+    batches++;
+  });
+
+  widget.show();
+  app.processEvents();
+  assert.equal(batches, 0);
+
+  var flag = false;
+  try {
+    widget.inputEvents([qt.EventType.Paint], function() {});
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'inputEvents() should throw on types it cannot batch');
+
+  widget.inputEvents(null);
+  widget.close();
+}
+
+// render(), grab(), grabAsync()
+{
+  var widget = new qt.QWidget;
+  widget.resize(40, 30);
+  widget.paintEvent(function() {
+    var painter = new qt.QPainter();
+    painter.begin(widget);
+    painter.fillRect(0, 0, 40, 30, new qt.QColor(255, 0, 0));
+    painter.fillRect(20, 0, 20, 30, new qt.QColor(0, 0, 255));
+    painter.end();
+  });
+
+  // Never shown
+  var image = widget.grab();
+  assert.equal(image.width(), 40);
+  assert.equal(image.height(), 30);
+  assert.equal(image.pixel(5, 5), 0xffff0000);
+  assert.equal(image.pixel(35, 5), 0xff0000ff);
+
+  var right = widget.grab(20, 0, 20, 30);
+  assert.equal(right.width(), 20);
+  assert.equal(right.pixel(5, 5), 0xff0000ff);
+
+  var target = new qt.QImage(60, 60, qt.ImageFormat.Format_ARGB32_Premultiplied);
+  target.fill(qt.GlobalColor.white);
+  widget.render(target, 10, 10);
+  assert.equal(target.pixel(5, 5), 0xffffffff);
+  assert.equal(target.pixel(15, 15), 0xffff0000);
+
+  var snapshots = 0;
+  [widget, new qt.QWidget].forEach(function(w) {
+    w.grabAsync(function(err, image) {
+      assert.ifError(err);
+      assert.equal(image.width(), w.width());
+      snapshots++;
+    });
+  });
+  app.processEvents();
+  assert.equal(snapshots, 2);
+}
+
+// Layers
+{
+  var layerPaints = 0;
+  var widget = new qt.QWidget;
+  widget.resize(100, 100);
+
+  widget.setLayer('background', 0, 0, 100, 100, 1, function(pixmap) {
+    layerPaints++;
+    var p = new qt.QPainter();
+    p.begin(pixmap);
+    p.fillRect(0, 0, 100, 100, qt.GlobalColor.blue);
+    p.end();
+  });
+
+  widget.show();
+  app.processEvents();
+  assert.equal(layerPaints, 1);
+
+  // Unchanged layers are blitted from cache
+  widget.update();
+  app.processEvents();
+  assert.equal(layerPaints, 1);
+
+  // Same version is a no-op, new version repaints
+  widget.setLayerVersion('background', 1);
+  app.processEvents();
+  assert.equal(layerPaints, 1);
+  widget.setLayerVersion('background', 2);
+  app.processEvents();
+  assert.equal(layerPaints, 2);
+
+  var flag = false;
+  try {
+    widget.setLayerVersion('nope', 1);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'setLayerVersion should throw on unknown layer');
+
+  widget.removeLayer('background');
+  app.processEvents();
+  assert.equal(layerPaints, 2);
+
+  widget.close();
+}
+
+// Layer callbacks that remove or replace layers
+{
+  var widget = new qt.QWidget;
+  widget.resize(100, 100);
+
+  var paints = [];
+  widget.setLayer('once', 0, 0, 50, 50, 1, function(pixmap) {
+    paints.push('once');
+    widget.removeLayer('once');
+  });
+  widget.setLayer('swap', 50, 50, 50, 50, 1, function(pixmap) {
+    paints.push('swap');
+    widget.setLayer('swap', 50, 50, 20, 20, 1, function(pixmap) {
+      paints.push('swapped');
+    });
+  });
+
+  widget.show();
+  app.processEvents();
+  widget.update();
+  app.processEvents();
+
+  assert.equal(paints.filter(function(p) { return p === 'once'; }).length, 1);
+  assert.ok(paints.indexOf('swapped') > 0, 'resized layers render again');
+
+  widget.close();
+}
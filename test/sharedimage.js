@@ -0,0 +1,116 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+var app = new qt.QApplication();
+
+var key = 'node-qt-test-' + process.pid;
+
+// Create and attach
+{
+  var owner = new qt.SharedImage(key, 32, 16, qt.ImageFormat.Format_RGB32);
+  assert.equal(owner.key(), key);
+  var image = owner.image();
+  assert.equal(image.width(), 32);
+  assert.equal(image.height(), 16);
+  assert.equal(image.format(), qt.ImageFormat.Format_RGB32);
+
+  // Another handle (normally in another process) sees the same pixels
+  var reader = new qt.SharedImage(key);
+  assert.equal(reader.image().width(), 32);
+
+  var painter = new qt.QPainter;
+  assert.equal(owner.lock(), true);
+  painter.begin(image);
+  painter.fillRect(0, 0, 32, 16, qt.GlobalColor.red);
+  painter.end();
+  owner.unlock();
+  assert.equal(reader.image().pixel(10, 10), 0xffff0000);
+
+  // publish()/serial()
+  assert.equal(reader.serial(), 0);
+  assert.equal(owner.publish(), 1);
+  assert.equal(reader.serial(), 1);
+
+  // Keys are unique while the segment exists
+  var flag = false;
+  try {
+    new qt.SharedImage(key, 4, 4);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'creating an existing key should throw');
+
+  // detach()
+  assert.strictEqual(owner.image(), image, 'image() returns one object');
+  reader.detach();
+  owner.detach();
+  assert.ok(image.isNull(), 'detach() nulls the image');
+  flag = false;
+  try {
+    owner.image();
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'image() should throw once detached');
+
+  // Both handles detached, so the segment is gone and the key is free
+  var again = new qt.SharedImage(key, 4, 4);
+  again.image();
+  again.detach();
+}
+
+// Errors
+{
+  var flag = false;
+  try {
+    new qt.SharedImage('node-qt-test-missing-' + process.pid);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'attaching to a missing key should throw');
+
+  flag = false;
+  try {
+    new qt.SharedImage(key + '-indexed', 4, 4, qt.ImageFormat.Format_Indexed8);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'non 32-bit formats should throw');
+
+  flag = false;
+  try {
+    new qt.SharedImage(key + '-huge', 1 << 20, 1 << 20);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'sizes that overflow the segment should throw');
+}
@@ -0,0 +1,144 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+var assert = require('assert'),
+    qt = require('..');
+
+// insert(), at(), topAt()
+{
+  var index = new qt.SpatialIndex(10);
+  index.insert(1, 0, 0, 20, 20);
+  index.insert(2, 10, 10, 20, 20);
+
+  var triangle = new qt.QPainterPath();
+  triangle.moveTo(new qt.QPointF(100, 100));
+  triangle.lineTo(new qt.QPointF(200, 100));
+  triangle.lineTo(new qt.QPointF(100, 200));
+  triangle.closeSubpath();
+  index.insert(3, triangle);
+
+  assert.equal(index.count(), 3);
+  assert.deepEqual(index.at(15, 15), [2, 1], 'topmost first');
+  assert.equal(index.topAt(15, 15), 2);
+  assert.equal(index.topAt(5, 5), 1);
+  assert.strictEqual(index.topAt(50, 50), null);
+
+  // Inside the triangle's bounds but outside the triangle itself
+  assert.equal(index.topAt(110, 110), 3);
+  assert.strictEqual(index.topAt(190, 190), null);
+
+  var flag = false;
+  try {
+    index.insert(1, 0, 0, 1, 1);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'insert() should throw on a duplicate id');
+}
+
+// update(), remove(), query()
+{
+  var index = new qt.SpatialIndex(10);
+  for (var i = 0; i < 10; i++)
+    index.insert(i, i * 10, 0, 10, 10);
+
+  assert.deepEqual(index.query(0, 0, 25, 5), [2, 1, 0]);
+
+  index.update(1, 500, 500, 10, 10);
+  assert.deepEqual(index.query(0, 0, 25, 5), [2, 0]);
+  assert.deepEqual(index.at(505, 505), [1]);
+
+  assert.ok(index.remove(2));
+  assert.ok(!index.remove(2));
+  assert.ok(!index.contains(2));
+  assert.deepEqual(index.query(0, 0, 25, 5), [0]);
+
+  // Shapes much larger than a cell
+  index.insert(100, 0, 0, 10000, 10000);
+  assert.equal(index.topAt(5000, 5000), 100);
+  assert.equal(index.query(-1e6, -1e6, 2e6, 2e6).length, 10);
+
+  var flag = false;
+  try {
+    index.update(42, 0, 0, 1, 1);
+  } catch (e) {
+    flag = true;
+  }
+  assert.ok(flag, 'update() should throw on an unknown id');
+
+  index.clear();
+  assert.equal(index.count(), 0);
+  assert.equal(index.query(-1e6, -1e6, 2e6, 2e6).length, 0);
+}
+
+// Huge and non-finite coordinates
+{
+  var index = new qt.SpatialIndex(1);
+  index.insert(1, 0, 0, 10, 10);
+  index.insert(2, -1e11, -1e11, 1, 1);
+  index.insert(3, 5e10, 0, 1e11, 1e11);
+
+  assert.deepEqual(index.query(-1e11, -1e11, 2e11, 2e11), [3, 2, 1]);
+  assert.deepEqual(index.at(-1e11, -1e11), [2]);
+  assert.deepEqual(index.at(1e11, 1e10), [3]);
+  assert.deepEqual(index.at(5, 5), [1]);
+
+  var bad = [
+    function() { index.insert(4, NaN, 0, 1, 1); },
+    function() { index.insert(4, 0, 0, Infinity, 1); },
+    function() { index.update(1, 0, -Infinity, 1, 1); },
+    function() { index.query(0, 0, NaN, 1); },
+    function() { index.at(Infinity, 0); },
+    function() { index.topAt(0, NaN); },
+    function() { new qt.SpatialIndex(Infinity); }
+  ];
+  bad.forEach(function(f) {
+    var flag = false;
+    try {
+      f();
+    } catch (e) {
+      flag = true;
+    }
+    assert.ok(flag, f + ' should throw');
+  });
+  assert.ok(!index.contains(4));
+}
+
+// 100k shapes, hover tests
+{
+  var index = new qt.SpatialIndex(32);
+  for (var i = 0; i < 100000; i++)
+    index.insert(i, (i % 1000) * 20, Math.floor(i / 1000) * 20, 16, 16);
+
+  var start = Date.now();
+  for (var i = 0; i < 10000; i++)
+    index.topAt(Math.random() * 20000, Math.random() * 2000);
+  var perQuery = (Date.now() - start) / 10000;
+  assert.ok(perQuery < 1, 'hover tests should be sub-millisecond');
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Converts images to the memory-mappable raw format loaded by
+// QImage.loadRaw(). Usage:
+//
+//   node tools/png2raw.js background.png [more.png ...]
+//
+// writes background.qraw etc. next to each input
+//
+
+var path = require('path'),
+    qt = require('..');
+
+var app = new qt.QApplication;
+
+var files = process.argv.slice(2);
+if (files.length === 0) {
+  console.error('usage: png2raw.js <image> [<image> ...]');
+  process.exit(1);
+}
+
+var failed = false;
+files.forEach(function(file) {
+  var image = new qt.QImage(file);
+  if (image.isNull()) {
+    console.error('png2raw: could not read ' + file);
+    failed = true;
+    return;
+  }
+
+  var out = path.join(path.dirname(file),
+                      path.basename(file, path.extname(file)) + '.qraw');
+  try {
+    image.saveRaw(out);
+    console.log(file + ' -> ' + out + ' (' + image.width() + 'x' +
+                image.height() + ')');
+  } catch (e) {
+    console.error('png2raw: ' + e.message);
+    failed = true;
+  }
+});
+
+process.exit(failed ? 1 : 0);
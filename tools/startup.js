@@ -0,0 +1,84 @@
+// Copyright (c) 2012, Artur Adib
+// All rights reserved.
+//
+// Author(s): Artur Adib <aadib@mozilla.com>
+//
+// You may use this file under the terms of the New BSD license as follows:
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Artur Adib nor the
+//       names of contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL ARTUR ADIB BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF 
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Measures how long require('node-qt') and first use of the bindings take,
+// each run in a fresh process. Usage:
+//
+//   node tools/startup.js [runs]
+//
+
+var spawn = require('child_process').spawn,
+    path = require('path');
+
+var root = path.join(__dirname, '..');
+var runs = parseInt(process.argv[2], 10) || 20;
+
+var cases = {
+  'require': '',
+  'require + QImage': 'var i = new qt.QImage(16, 16, qt.ImageFormat.Format_RGB32);',
+  'require + all classes': 'for (var k in qt) qt[k];'
+};
+
+function script(body) {
+  return 'var t = process.hrtime();' +
+         'var qt = require(' + JSON.stringify(root) + ');' + body +
+         't = process.hrtime(t);' +
+         'console.log(t[0] * 1e3 + t[1] / 1e6);';
+}
+
+function run(name, body, left, times, done) {
+  if (left === 0)
+    return done(times);
+
+  var child = spawn(process.execPath, ['-e', script(body)]);
+  var out = '';
+  child.stdout.on('data', function(data) { out += data; });
+  child.on('exit', function(code) {
+    if (code !== 0) {
+      console.error('startup: ' + name + ' exited with code ' + code);
+      process.exit(1);
+    }
+    times.push(parseFloat(out));
+    run(name, body, left - 1, times, done);
+  });
+}
+
+var names = Object.keys(cases);
+(function next(i) {
+  if (i === names.length)
+    return;
+
+  run(names[i], cases[names[i]], runs, [], function(times) {
+    times.sort(function(a, b) { return a - b; });
+    console.log(names[i] + ': median ' + times[times.length >> 1].toFixed(2) +
+                ' ms, min ' + times[0].toFixed(2) + ' ms (' + runs + ' runs)');
+    next(i + 1);
+  });
+})(0);